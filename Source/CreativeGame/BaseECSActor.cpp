@@ -5,10 +5,13 @@
 #include "BaseECSPawn.h"
 #include "BaseECSPlayerController.h"
 #include "Engine/World.h"
-#include "Kismet/GameplayStatics.h"
+#include "Subsystems/ECSActorRegistrySubsystem.h"
+#include "Subsystems/ECSSpatialHashSubsystem.h"
+#include "Subsystems/ECSSpatialQueryCacheSubsystem.h"
 
 ABaseECSActor::ABaseECSActor()
 {
+	// Ticking is released by the capability manager when the world scheduler takes over or no capability needs it
 	PrimaryActorTick.bCanEverTick = true;
 
 	// Create the capability manager component
@@ -25,6 +28,18 @@ void ABaseECSActor::BeginPlay()
 {
 	Super::BeginPlay();
 
+	// Make this actor visible to the GetNearbyECS* spatial queries
+	if (UECSSpatialHashSubsystem* SpatialHash = UECSSpatialHashSubsystem::Get(this))
+	{
+		SpatialHash->RegisterActor(this);
+	}
+
+	// Class-filtered iteration goes through the registry instead of the world's actor list
+	if (UECSActorRegistrySubsystem* Registry = UECSActorRegistrySubsystem::Get(this))
+	{
+		Registry->RegisterActor(this);
+	}
+
 	// Initialize capabilities through the manager
 	if (CapabilityManager)
 	{
@@ -32,12 +47,27 @@ void ABaseECSActor::BeginPlay()
 	}
 }
 
+void ABaseECSActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UECSSpatialHashSubsystem* SpatialHash = UECSSpatialHashSubsystem::Get(this))
+	{
+		SpatialHash->UnregisterActor(this);
+	}
+
+	if (UECSActorRegistrySubsystem* Registry = UECSActorRegistrySubsystem::Get(this))
+	{
+		Registry->UnregisterActor(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void ABaseECSActor::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	// Manual tick capabilities if enabled
-	if (bManualCapabilityTicking && CapabilityManager)
+	// Manual tick capabilities if enabled and the world scheduler isn't already batch-ticking them
+	if (bManualCapabilityTicking && CapabilityManager && !CapabilityManager->IsTickedByScheduler())
 	{
 		CapabilityManager->ManualTick(DeltaTime);
 	}
@@ -47,23 +77,9 @@ TArray<ABaseECSActor*> ABaseECSActor::GetNearbyECSActors(float Radius) const
 {
 	TArray<ABaseECSActor*> NearbyECSActors;
 
-	if (UWorld* World = GetWorld())
+	if (UECSSpatialQueryCacheSubsystem* QueryCache = UECSSpatialQueryCacheSubsystem::Get(this))
 	{
-		TArray<AActor*> AllActors;
-		UGameplayStatics::GetAllActorsOfClass(World, ABaseECSActor::StaticClass(), AllActors);
-
-		const FVector MyLocation = GetActorLocation();
-
-		for (AActor* Actor : AllActors)
-		{
-			if (Actor != this && FVector::Dist(Actor->GetActorLocation(), MyLocation) <= Radius)
-			{
-				if (ABaseECSActor* ECSActor = Cast<ABaseECSActor>(Actor))
-				{
-					NearbyECSActors.Add(ECSActor);
-				}
-			}
-		}
+		QueryCache->QueryRadius(this, Radius, NearbyECSActors);
 	}
 
 	return NearbyECSActors;
@@ -73,23 +89,9 @@ TArray<ABaseECSPawn*> ABaseECSActor::GetNearbyECSPawns(float Radius) const
 {
 	TArray<ABaseECSPawn*> NearbyECSPawns;
 
-	if (UWorld* World = GetWorld())
+	if (UECSSpatialQueryCacheSubsystem* QueryCache = UECSSpatialQueryCacheSubsystem::Get(this))
 	{
-		TArray<AActor*> AllPawns;
-		UGameplayStatics::GetAllActorsOfClass(World, ABaseECSPawn::StaticClass(), AllPawns);
-
-		const FVector MyLocation = GetActorLocation();
-
-		for (AActor* Actor : AllPawns)
-		{
-			if (Actor != this && FVector::Dist(Actor->GetActorLocation(), MyLocation) <= Radius)
-			{
-				if (ABaseECSPawn* ECSPawn = Cast<ABaseECSPawn>(Actor))
-				{
-					NearbyECSPawns.Add(ECSPawn);
-				}
-			}
-		}
+		QueryCache->QueryRadius(this, Radius, NearbyECSPawns);
 	}
 
 	return NearbyECSPawns;
@@ -99,23 +101,9 @@ TArray<ABaseECSCharacter*> ABaseECSActor::GetNearbyECSCharacters(float Radius) c
 {
 	TArray<ABaseECSCharacter*> NearbyECSCharacters;
 
-	if (UWorld* World = GetWorld())
+	if (UECSSpatialQueryCacheSubsystem* QueryCache = UECSSpatialQueryCacheSubsystem::Get(this))
 	{
-		TArray<AActor*> AllCharacters;
-		UGameplayStatics::GetAllActorsOfClass(World, ABaseECSCharacter::StaticClass(), AllCharacters);
-
-		const FVector MyLocation = GetActorLocation();
-
-		for (AActor* Actor : AllCharacters)
-		{
-			if (Actor != this && FVector::Dist(Actor->GetActorLocation(), MyLocation) <= Radius)
-			{
-				if (ABaseECSCharacter* ECSCharacter = Cast<ABaseECSCharacter>(Actor))
-				{
-					NearbyECSCharacters.Add(ECSCharacter);
-				}
-			}
-		}
+		QueryCache->QueryRadius(this, Radius, NearbyECSCharacters);
 	}
 
 	return NearbyECSCharacters;
@@ -146,32 +134,10 @@ ABaseECSActor* ABaseECSActor::GetClosestECSActor(TSubclassOf<ABaseECSActor> Acto
 		return nullptr;
 	}
 
-	ABaseECSActor* ClosestActor = nullptr;
-	float ClosestDistance = FLT_MAX;
-
-	if (UWorld* World = GetWorld())
+	if (const UECSSpatialHashSubsystem* SpatialHash = UECSSpatialHashSubsystem::Get(this))
 	{
-		TArray<AActor*> AllActors;
-		UGameplayStatics::GetAllActorsOfClass(World, ActorClass, AllActors);
-
-		const FVector MyLocation = GetActorLocation();
-
-		for (AActor* Actor : AllActors)
-		{
-			if (Actor != this)
-			{
-				float Distance = FVector::Dist(Actor->GetActorLocation(), MyLocation);
-				if (Distance < ClosestDistance)
-				{
-					if (ABaseECSActor* ECSActor = Cast<ABaseECSActor>(Actor))
-					{
-						ClosestDistance = Distance;
-						ClosestActor = ECSActor;
-					}
-				}
-			}
-		}
+		return Cast<ABaseECSActor>(SpatialHash->FindClosestActor(GetActorLocation(), ActorClass, this));
 	}
 
-	return ClosestActor;
+	return nullptr;
 }
\ No newline at end of file
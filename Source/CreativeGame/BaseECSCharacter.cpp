@@ -6,11 +6,14 @@
 #include "BaseECSPawn.h"
 #include "Components/InputComponent.h"
 #include "Engine/World.h"
-#include "Kismet/GameplayStatics.h"
+#include "Subsystems/ECSActorRegistrySubsystem.h"
+#include "Subsystems/ECSSpatialHashSubsystem.h"
+#include "Subsystems/ECSSpatialQueryCacheSubsystem.h"
 #include "GameFramework/PlayerController.h"
 
 ABaseECSCharacter::ABaseECSCharacter()
 {
+	// Ticking is released by the capability manager when the world scheduler takes over or no capability needs it
 	PrimaryActorTick.bCanEverTick = true;
 	
 	// Create the capability manager component
@@ -31,6 +34,18 @@ void ABaseECSCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 	
+	// Make this actor visible to the GetNearbyECS* spatial queries
+	if (UECSSpatialHashSubsystem* SpatialHash = UECSSpatialHashSubsystem::Get(this))
+	{
+		SpatialHash->RegisterActor(this);
+	}
+
+	// Class-filtered iteration goes through the registry instead of the world's actor list
+	if (UECSActorRegistrySubsystem* Registry = UECSActorRegistrySubsystem::Get(this))
+	{
+		Registry->RegisterActor(this);
+	}
+	
 	// Initialize capabilities through the manager
 	if (CapabilityManager)
 	{
@@ -47,6 +62,21 @@ void ABaseECSCharacter::BeginPlay()
 	}
 }
 
+void ABaseECSCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UECSSpatialHashSubsystem* SpatialHash = UECSSpatialHashSubsystem::Get(this))
+	{
+		SpatialHash->UnregisterActor(this);
+	}
+
+	if (UECSActorRegistrySubsystem* Registry = UECSActorRegistrySubsystem::Get(this))
+	{
+		Registry->UnregisterActor(this);
+	}
+	
+	Super::EndPlay(EndPlayReason);
+}
+
 void ABaseECSCharacter::PossessedBy(AController* NewController)
 {
 	// If auto-correction is enabled and this isn't an ECS controller
@@ -71,8 +101,8 @@ void ABaseECSCharacter::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	// Manual tick capabilities if enabled
-	if (bManualCapabilityTicking && CapabilityManager)
+	// Manual tick capabilities if enabled and the world scheduler isn't already batch-ticking them
+	if (bManualCapabilityTicking && CapabilityManager && !CapabilityManager->IsTickedByScheduler())
 	{
 		CapabilityManager->ManualTick(DeltaTime);
 	}
@@ -161,24 +191,9 @@ TArray<ABaseECSActor*> ABaseECSCharacter::GetNearbyECSActors(float Radius) const
 {
 	TArray<ABaseECSActor*> NearbyECSActors;
 	
-	if (UWorld* World = GetWorld())
+	if (UECSSpatialQueryCacheSubsystem* QueryCache = UECSSpatialQueryCacheSubsystem::Get(this))
 	{
-		// Get all actors within radius
-		TArray<AActor*> AllActors;
-		UGameplayStatics::GetAllActorsOfClass(World, ABaseECSActor::StaticClass(), AllActors);
-		
-		const FVector MyLocation = GetActorLocation();
-		
-		for (AActor* Actor : AllActors)
-		{
-			if (Actor != this && FVector::Dist(Actor->GetActorLocation(), MyLocation) <= Radius)
-			{
-				if (ABaseECSActor* ECSActor = Cast<ABaseECSActor>(Actor))
-				{
-					NearbyECSActors.Add(ECSActor);
-				}
-			}
-		}
+		QueryCache->QueryRadius(this, Radius, NearbyECSActors);
 	}
 	
 	return NearbyECSActors;
@@ -188,24 +203,9 @@ TArray<ABaseECSPawn*> ABaseECSCharacter::GetNearbyECSPawns(float Radius) const
 {
 	TArray<ABaseECSPawn*> NearbyECSPawns;
 	
-	if (UWorld* World = GetWorld())
+	if (UECSSpatialQueryCacheSubsystem* QueryCache = UECSSpatialQueryCacheSubsystem::Get(this))
 	{
-		// Get all pawns within radius
-		TArray<AActor*> AllPawns;
-		UGameplayStatics::GetAllActorsOfClass(World, ABaseECSPawn::StaticClass(), AllPawns);
-		
-		const FVector MyLocation = GetActorLocation();
-		
-		for (AActor* Actor : AllPawns)
-		{
-			if (Actor != this && FVector::Dist(Actor->GetActorLocation(), MyLocation) <= Radius)
-			{
-				if (ABaseECSPawn* ECSPawn = Cast<ABaseECSPawn>(Actor))
-				{
-					NearbyECSPawns.Add(ECSPawn);
-				}
-			}
-		}
+		QueryCache->QueryRadius(this, Radius, NearbyECSPawns);
 	}
 	
 	return NearbyECSPawns;
@@ -215,24 +215,9 @@ TArray<ABaseECSCharacter*> ABaseECSCharacter::GetNearbyECSCharacters(float Radiu
 {
 	TArray<ABaseECSCharacter*> NearbyECSCharacters;
 	
-	if (UWorld* World = GetWorld())
+	if (UECSSpatialQueryCacheSubsystem* QueryCache = UECSSpatialQueryCacheSubsystem::Get(this))
 	{
-		// Get all characters within radius
-		TArray<AActor*> AllCharacters;
-		UGameplayStatics::GetAllActorsOfClass(World, ABaseECSCharacter::StaticClass(), AllCharacters);
-		
-		const FVector MyLocation = GetActorLocation();
-		
-		for (AActor* Actor : AllCharacters)
-		{
-			if (Actor != this && FVector::Dist(Actor->GetActorLocation(), MyLocation) <= Radius)
-			{
-				if (ABaseECSCharacter* ECSCharacter = Cast<ABaseECSCharacter>(Actor))
-				{
-					NearbyECSCharacters.Add(ECSCharacter);
-				}
-			}
-		}
+		QueryCache->QueryRadius(this, Radius, NearbyECSCharacters);
 	}
 	
 	return NearbyECSCharacters;
@@ -4,7 +4,7 @@
 #include "ECSPawnInterface.h"
 #include "Engine/World.h"
 #include "Engine/NetConnection.h"
-#include "Kismet/GameplayStatics.h"
+#include "EngineUtils.h"
 #include "GameFramework/PlayerController.h"
 
 ABaseECSGameMode::ABaseECSGameMode()
@@ -168,34 +168,30 @@ void ABaseECSGameMode::FixExistingPawns()
 {
 	if (UWorld* World = GetWorld())
 	{
-		// Find all pawns with auto-possess settings and validate they're ECS
-		TArray<AActor*> AllPawns;
-		UGameplayStatics::GetAllActorsOfClass(World, APawn::StaticClass(), AllPawns);
-		
-		for (AActor* Actor : AllPawns)
+		// Non-ECS pawns never register, so this cold path keeps one walk over the world's pawns
+		for (TActorIterator<APawn> It(World); It; ++It)
 		{
-			if (APawn* Pawn = Cast<APawn>(Actor))
+			APawn* Pawn = *It;
+
+			// Check if this pawn has auto-possess enabled
+			if (Pawn->AutoPossessPlayer != EAutoReceiveInput::Disabled)
 			{
-				// Check if this pawn has auto-possess enabled
-				if (Pawn->AutoPossessPlayer != EAutoReceiveInput::Disabled)
+				// Use the ECS interface to check if it's an ECS pawn
+				IECSPawnInterface* ECSPawnInterface = Cast<IECSPawnInterface>(Pawn);
+				
+				if (!ECSPawnInterface)
+				{
+					UE_LOG(LogTemp, Warning, TEXT("Found non-ECS Pawn with auto-possess: %s (Class: %s). Consider changing to ABaseECSCharacter or ABaseECSPawn."), 
+						*Pawn->GetName(), *Pawn->GetClass()->GetName());
+				}
+				else
 				{
-					// Use the ECS interface to check if it's an ECS pawn
-					IECSPawnInterface* ECSPawnInterface = Cast<IECSPawnInterface>(Pawn);
-					
-					if (!ECSPawnInterface)
-					{
-						UE_LOG(LogTemp, Warning, TEXT("Found non-ECS Pawn with auto-possess: %s (Class: %s). Consider changing to ABaseECSCharacter or ABaseECSPawn."), 
-							*Pawn->GetName(), *Pawn->GetClass()->GetName());
-					}
-					else
-					{
-						// Log success for debugging
-						const char* TypeName = Cast<ABaseECSCharacter>(Pawn) ? "ECS Character" : "ECS Pawn";
-						UE_LOG(LogTemp, Log, TEXT("Found valid ECS Pawn: %s (Class: %s) - %hs"), 
-							*Pawn->GetName(), 
-							*Pawn->GetClass()->GetName(),
-							TypeName);
-					}
+					// Log success for debugging
+					const char* TypeName = Cast<ABaseECSCharacter>(Pawn) ? "ECS Character" : "ECS Pawn";
+					UE_LOG(LogTemp, Log, TEXT("Found valid ECS Pawn: %s (Class: %s) - %hs"), 
+						*Pawn->GetName(), 
+						*Pawn->GetClass()->GetName(),
+						TypeName);
 				}
 			}
 		}
@@ -6,7 +6,7 @@
 #include "BaseECSActor.h"
 #include "Components/InputComponent.h"
 #include "Engine/World.h"
-#include "Kismet/GameplayStatics.h"
+#include "Subsystems/ECSSpatialHashSubsystem.h"
 
 ABaseECSPlayerController::ABaseECSPlayerController()
 {
@@ -19,6 +19,10 @@ ABaseECSPlayerController::ABaseECSPlayerController()
 	if (CapabilityManager)
 	{
 		CapabilityManager->SetComponentTickEnabled(false);
+
+		// PlayerTick drives input processing, so the controller keeps its own tick even when capabilities are scheduled or idle
+		CapabilityManager->SetReleaseOwnerTickWhenScheduled(false);
+		CapabilityManager->SetAllowOwnerTickDormancy(false);
 	}
 }
 
@@ -48,8 +52,8 @@ void ABaseECSPlayerController::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	// Manual tick capabilities if enabled
-	if (bManualCapabilityTicking && CapabilityManager)
+	// Manual tick capabilities if enabled and the world scheduler isn't already batch-ticking them
+	if (bManualCapabilityTicking && CapabilityManager && !CapabilityManager->IsTickedByScheduler())
 	{
 		CapabilityManager->ManualTick(DeltaTime);
 	}
@@ -79,7 +83,7 @@ TArray<ABaseECSActor*> ABaseECSPlayerController::GetNearbyECSActors(float Radius
 {
 	TArray<ABaseECSActor*> NearbyECSActors;
 	
-	if (UWorld* World = GetWorld())
+	if (const UECSSpatialHashSubsystem* SpatialHash = UECSSpatialHashSubsystem::Get(this))
 	{
 		// Use the possessed pawn's location, or a default location as fallback
 		FVector SearchLocation = FVector::ZeroVector;
@@ -94,19 +98,7 @@ TArray<ABaseECSActor*> ABaseECSPlayerController::GetNearbyECSActors(float Radius
 		}
 		
 		// Get all ECS actors within radius
-		TArray<AActor*> AllActors;
-		UGameplayStatics::GetAllActorsOfClass(World, ABaseECSActor::StaticClass(), AllActors);
-		
-		for (AActor* Actor : AllActors)
-		{
-			if (FVector::Dist(Actor->GetActorLocation(), SearchLocation) <= Radius)
-			{
-				if (ABaseECSActor* ECSActor = Cast<ABaseECSActor>(Actor))
-				{
-					NearbyECSActors.Add(ECSActor);
-				}
-			}
-		}
+		SpatialHash->QueryRadius(SearchLocation, Radius, nullptr, NearbyECSActors);
 	}
 	
 	return NearbyECSActors;
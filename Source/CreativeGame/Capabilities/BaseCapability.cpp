@@ -1,4 +1,12 @@
 #include "BaseCapability.h"
+#include "../Components/BaseComponent.h"
+#include "../Subsystems/CapabilitySchedulerSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "TimerManager.h"
+
+// Next dense capability type index - class default objects can be created on the async loading thread
+static FThreadSafeCounter NextCapabilityTypeId;
 
 UBaseCapability::UBaseCapability()
 {
@@ -11,6 +19,35 @@ UBaseCapability::UBaseCapability()
     bAutoActivate = bStartActive;
 }
 
+void UBaseCapability::PostInitProperties()
+{
+    Super::PostInitProperties();
+
+    // Every class gets its index once through its default object, instances just copy it
+    if (HasAnyFlags(RF_ClassDefaultObject))
+    {
+        CapabilityTypeId = NextCapabilityTypeId.Increment() - 1;
+    }
+    else
+    {
+        CapabilityTypeId = GetClass()->GetDefaultObject<UBaseCapability>()->CapabilityTypeId;
+    }
+}
+
+int32 UBaseCapability::GetCapabilityTypeId(const UClass* CapabilityClass)
+{
+    if (!CapabilityClass || !CapabilityClass->IsChildOf(UBaseCapability::StaticClass()))
+    {
+        return INDEX_NONE;
+    }
+    return CapabilityClass->GetDefaultObject<UBaseCapability>()->CapabilityTypeId;
+}
+
+int32 UBaseCapability::GetNumCapabilityTypes()
+{
+    return NextCapabilityTypeId.GetValue();
+}
+
 void UBaseCapability::BeginPlay()
 {
     Super::BeginPlay();
@@ -22,6 +59,59 @@ void UBaseCapability::BeginPlay()
     // If bAutoActivate is true, the component will automatically activate
 }
 
+void UBaseCapability::SetPriority(int32 NewPriority)
+{
+    if (Priority == NewPriority)
+    {
+        return;
+    }
+
+    Priority = NewPriority;
+
+    // Buckets are per class and priority, so the tick budget orders this instance by its own priority
+    if (SchedulerBucketIndex != INDEX_NONE && ensure(IsInGameThread()))
+    {
+        if (UCapabilitySchedulerSubsystem* Scheduler = GetWorld() ? GetWorld()->GetSubsystem<UCapabilitySchedulerSubsystem>() : nullptr)
+        {
+            Scheduler->RemoveFromTickBucket(this);
+            Scheduler->AddToTickBucket(this);
+        }
+    }
+}
+
+void UBaseCapability::OnComponentDestroyed(bool bDestroyingHierarchy)
+{
+    // Destroyed without going through the manager - make sure the scheduler drops its pointer
+    if (SchedulerBucketIndex != INDEX_NONE)
+    {
+        if (UCapabilitySchedulerSubsystem* Scheduler = GetWorld() ? GetWorld()->GetSubsystem<UCapabilitySchedulerSubsystem>() : nullptr)
+        {
+            Scheduler->RemoveFromTickBucket(this);
+        }
+    }
+
+    Super::OnComponentDestroyed(bDestroyingHierarchy);
+}
+
+void UBaseCapability::ResetCapability_Implementation()
+{
+    const UBaseCapability* DefaultCapability = GetClass()->GetDefaultObject<UBaseCapability>();
+    Priority = DefaultCapability->Priority;
+
+    bActivationDirty = false;
+    bPredicateQueued = false;
+    LastDeactivationTime = -1.0f;
+    if (UWorld* World = GetWorld())
+    {
+        World->GetTimerManager().ClearTimer(CooldownTimerHandle);
+    }
+    bSchedulerForceGameThread = false;
+    CurrentTickLODLevel = INDEX_NONE;
+    FramesSinceLODTick = 0;
+    AccumulatedLODDeltaTime = 0.0f;
+    ScheduledDeltaTime = 0.0f;
+}
+
 void UBaseCapability::OnCapabilityDeactivated_Implementation()
 {
 }
@@ -68,4 +158,110 @@ bool UBaseCapability::ShouldActivate_Implementation()
 {
     // Override in Blueprint or C++
     return true;
+}
+
+bool UBaseCapability::DependsOnComponent(const UBaseComponent* Component, FName FieldName) const
+{
+    if (ActivationMode != ECapabilityActivationMode::EventDriven || !Component)
+    {
+        return false;
+    }
+
+    for (const FCapabilityActivationDependency& Dependency : ActivationDependencies)
+    {
+        // An unnamed change or an unnamed dependency matches any field
+        if (Dependency.ComponentClass && Component->IsA(Dependency.ComponentClass)
+            && (FieldName.IsNone() || Dependency.FieldName.IsNone() || FieldName == Dependency.FieldName))
+        {
+            return true;
+        }
+    }
+
+    if (bUseActivationPredicate)
+    {
+        for (const FCapabilityFieldCondition& Condition : ActivationPredicate.FieldConditions)
+        {
+            if (Condition.ComponentClass && Component->IsA(Condition.ComponentClass) && (FieldName.IsNone() || FieldName == Condition.FieldName))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool UBaseCapability::DependsOnTag(FName Tag) const
+{
+    if (ActivationMode != ECapabilityActivationMode::EventDriven)
+    {
+        return false;
+    }
+
+    return ActivationTagDependencies.Contains(Tag)
+        || (bUseActivationPredicate && (ActivationPredicate.RequiredTags.Contains(Tag) || ActivationPredicate.BlockedTags.Contains(Tag)));
+}
+
+float UBaseCapability::GetRemainingCooldown(float CurrentTime) const
+{
+    if (!bUseActivationPredicate || ActivationPredicate.Cooldown <= 0.0f || LastDeactivationTime < 0.0f)
+    {
+        return 0.0f;
+    }
+    return ActivationPredicate.Cooldown - (CurrentTime - LastDeactivationTime);
+}
+
+bool UBaseCapability::AdvanceTickLOD(float DeltaTime, float SignificanceDistance, float& OutDeltaTime)
+{
+    // Levels are few and authored in any order, pick the furthest one we're beyond
+    int32 NewLevel = INDEX_NONE;
+    for (int32 LevelIndex = 0; LevelIndex < TickLODLevels.Num(); ++LevelIndex)
+    {
+        if (SignificanceDistance >= TickLODLevels[LevelIndex].MinDistance
+            && (NewLevel == INDEX_NONE || TickLODLevels[LevelIndex].MinDistance > TickLODLevels[NewLevel].MinDistance))
+        {
+            NewLevel = LevelIndex;
+        }
+    }
+
+    if (NewLevel == INDEX_NONE)
+    {
+        // Closer than every level - full rate
+        CurrentTickLODLevel = INDEX_NONE;
+        OutDeltaTime = DeltaTime + AccumulatedLODDeltaTime;
+        AccumulatedLODDeltaTime = 0.0f;
+        return true;
+    }
+
+    const FCapabilityTickLODLevel& Level = TickLODLevels[NewLevel];
+    if (NewLevel != CurrentTickLODLevel)
+    {
+        CurrentTickLODLevel = NewLevel;
+
+        // Start at a per-object phase so capabilities entering the level together don't tick in the same frame
+        FramesSinceLODTick = Level.TickRate == ECapabilityTickRate::EveryNFrames ? GetUniqueID() % FMath::Max(Level.FrameInterval, 1) : 0;
+    }
+
+    switch (Level.TickRate)
+    {
+    case ECapabilityTickRate::Paused:
+        AccumulatedLODDeltaTime = 0.0f;
+        return false;
+
+    case ECapabilityTickRate::EveryNFrames:
+        AccumulatedLODDeltaTime += DeltaTime;
+        if (++FramesSinceLODTick < Level.FrameInterval)
+        {
+            return false;
+        }
+        FramesSinceLODTick = 0;
+        break;
+
+    default:
+        AccumulatedLODDeltaTime += DeltaTime;
+        break;
+    }
+
+    OutDeltaTime = AccumulatedLODDeltaTime;
+    AccumulatedLODDeltaTime = 0.0f;
+    return true;
 }
\ No newline at end of file
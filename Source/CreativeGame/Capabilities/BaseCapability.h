@@ -2,8 +2,77 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "CapabilityActivationPredicate.h"
+#include "Engine/TimerHandle.h"
+
+class UBaseComponent;
+class UCapabilityManagerComponent;
+
 #include "BaseCapability.generated.h"
 
+/**
+ * How a capability's ShouldBeActive/ShouldActivate/ShouldDeactivate are re-evaluated by its manager.
+ */
+UENUM(BlueprintType)
+enum class ECapabilityActivationMode : uint8
+{
+    // Re-evaluated every CapabilityUpdateFrequency seconds, whether anything changed or not
+    Polling,
+
+    // Re-evaluated only when a declared activation dependency changes (or a state update is requested)
+    EventDriven
+};
+
+/**
+ * A component (and optionally a single field of it) that an event-driven capability's activation depends on.
+ * Components report changes with UBaseComponent::MarkFieldChanged.
+ */
+USTRUCT(BlueprintType)
+struct FCapabilityActivationDependency
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capabilities")
+    TSubclassOf<UBaseComponent> ComponentClass;
+
+    // Leave empty to depend on any change of the component
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capabilities")
+    FName FieldName;
+};
+
+/**
+ * How often a capability ticks at a given tick LOD level.
+ */
+UENUM(BlueprintType)
+enum class ECapabilityTickRate : uint8
+{
+    EveryFrame,
+
+    // Tick once every FrameInterval frames with the DeltaTime accumulated since the last tick
+    EveryNFrames,
+
+    // Don't tick at all, time spent paused is dropped
+    Paused
+};
+
+/**
+ * Tick rate used while the owner is at least MinDistance away from the closest player viewpoint.
+ */
+USTRUCT(BlueprintType)
+struct FCapabilityTickLODLevel
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capabilities", meta = (ClampMin = "0"))
+    float MinDistance = 0.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capabilities")
+    ECapabilityTickRate TickRate = ECapabilityTickRate::EveryFrame;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capabilities", meta = (ClampMin = "2", EditCondition = "TickRate == ECapabilityTickRate::EveryNFrames"))
+    int32 FrameInterval = 2;
+};
+
 /**
  * Base capability class that provides behavior to actors.
  * Capabilities can be activated/deactivated and are ticked manually by their owner.
@@ -44,11 +113,71 @@ public:
     UFUNCTION(BlueprintPure, Category = "Capabilities")
     int32 GetPriority() const { return Priority; }
 
+    // Per-instance override, an active capability moves to the scheduler bucket of its new priority. Game thread only.
     UFUNCTION(BlueprintCallable, Category = "Capabilities")
-    void SetPriority(int32 NewPriority) { Priority = NewPriority; }
+    void SetPriority(int32 NewPriority);
+
+    // The manager this capability was added to, if any
+    UFUNCTION(BlueprintPure, Category = "Capabilities")
+    UCapabilityManagerComponent* GetOwningManager() const { return OwningManager; }
+
+    // Worker-thread tick, used instead of TickCapability when the class opts in with bTickOnWorkerThread.
+    // Runs in parallel with other capabilities, so it must only touch the declared components of its owner.
+    virtual void TickCapabilityConcurrent(float DeltaTime) {}
+
+    // Only native classes can tick on worker threads, Blueprint and script code must stay on the game thread
+    bool CanTickOnWorkerThread() const { return bTickOnWorkerThread && GetClass()->HasAnyClassFlags(CLASS_Native); }
+
+    const TArray<TSubclassOf<UBaseComponent>>& GetReadComponents() const { return ReadComponents; }
+    const TArray<TSubclassOf<UBaseComponent>>& GetWriteComponents() const { return WriteComponents; }
+
+    // Event-driven activation
+    UFUNCTION(BlueprintPure, Category = "Capabilities")
+    ECapabilityActivationMode GetActivationMode() const { return ActivationMode; }
+
+    bool DependsOnComponent(const UBaseComponent* Component, FName FieldName) const;
+    bool DependsOnTag(FName Tag) const;
+
+    // Declarative activation - when set, the predicate replaces ShouldBeActive/ShouldActivate/ShouldDeactivate
+    bool UsesActivationPredicate() const { return bUseActivationPredicate; }
+    const FCapabilityActivationPredicate& GetActivationPredicate() const { return ActivationPredicate; }
+
+    // Seconds until the predicate's cooldown lets the capability activate again, 0 or less once it may
+    float GetRemainingCooldown(float CurrentTime) const;
+
+    // Tick LOD - capabilities without levels tick every frame
+    bool UsesTickLOD() const { return !TickLODLevels.IsEmpty(); }
+
+    // Advance the tick LOD by one frame at the given distance, returns whether to tick and the DeltaTime to tick with
+    bool AdvanceTickLOD(float DeltaTime, float SignificanceDistance, float& OutDeltaTime);
+
+    UFUNCTION(BlueprintPure, Category = "Capabilities")
+    int32 GetTickLODLevel() const { return CurrentTickLODLevel; }
+
+    // Sleeping capabilities stay active but aren't ticked until their manager wakes them
+    UFUNCTION(BlueprintPure, Category = "Capabilities")
+    bool IsSleeping() const { return bSleeping; }
+
+    // Pooling - removed instances of pooled classes are reset and reused by UCapabilityPoolSubsystem
+    bool IsPooled() const { return bPoolInstances; }
+
+    // Called before a removed instance goes back to the pool. Override to clear per-owner state,
+    // the base version restores the default priority and tick LOD state.
+    UFUNCTION(BlueprintNativeEvent, Category = "Capabilities")
+    void ResetCapability();
+
+    // Dense runtime type index of this capability's class, assigned when the class default object is created
+    int32 GetCapabilityTypeId() const { return CapabilityTypeId; }
+    static int32 GetCapabilityTypeId(const UClass* CapabilityClass);
+
+    // Number of capability type indices handed out so far
+    static int32 GetNumCapabilityTypes();
+
+    virtual void PostInitProperties() override;
 
 protected:
     virtual void BeginPlay() override;
+    virtual void OnComponentDestroyed(bool bDestroyingHierarchy) override;
 
     // Called when capability is activated - override for custom behavior
     UFUNCTION(BlueprintNativeEvent, Category = "Capabilities")
@@ -63,4 +192,88 @@ protected:
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capability Settings")
     bool bStartActive = false;
+
+    // Reuse removed instances through the world's capability pool. Only enable when ResetCapability clears all per-owner state.
+    UPROPERTY(EditDefaultsOnly, Category = "Capability Settings|Pooling")
+    bool bPoolInstances = false;
+
+    // Tick through TickCapabilityConcurrent on worker threads, in parallel with capabilities that don't conflict
+    UPROPERTY(EditDefaultsOnly, Category = "Capability Settings|Threading")
+    bool bTickOnWorkerThread = false;
+
+    // Component types TickCapabilityConcurrent reads on the owner
+    UPROPERTY(EditDefaultsOnly, Category = "Capability Settings|Threading", meta = (EditCondition = "bTickOnWorkerThread"))
+    TArray<TSubclassOf<UBaseComponent>> ReadComponents;
+
+    // Component types TickCapabilityConcurrent writes on the owner
+    UPROPERTY(EditDefaultsOnly, Category = "Capability Settings|Threading", meta = (EditCondition = "bTickOnWorkerThread"))
+    TArray<TSubclassOf<UBaseComponent>> WriteComponents;
+
+    // Polling re-checks activation periodically, EventDriven only when one of the dependencies below changes
+    UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Capability Settings|Activation")
+    ECapabilityActivationMode ActivationMode = ECapabilityActivationMode::Polling;
+
+    // Components whose changes can affect ShouldBeActive/ShouldActivate/ShouldDeactivate
+    UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Capability Settings|Activation", meta = (EditCondition = "ActivationMode == ECapabilityActivationMode::EventDriven"))
+    TArray<FCapabilityActivationDependency> ActivationDependencies;
+
+    // Owner actor tags whose addition or removal can affect activation
+    UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Capability Settings|Activation", meta = (EditCondition = "ActivationMode == ECapabilityActivationMode::EventDriven"))
+    TArray<FName> ActivationTagDependencies;
+
+    // Activate from ActivationPredicate instead of the Should* events. The scheduler evaluates it for every queued
+    // capability of the class in one batch. Event-driven capabilities also depend on the tags and fields it reads.
+    UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Capability Settings|Activation")
+    bool bUseActivationPredicate = false;
+
+    UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Capability Settings|Activation", meta = (EditCondition = "bUseActivationPredicate"))
+    FCapabilityActivationPredicate ActivationPredicate;
+
+    // Tick rate by distance to the closest player viewpoint, the level with the largest MinDistance in range applies
+    UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Capability Settings|LOD")
+    TArray<FCapabilityTickLODLevel> TickLODLevels;
+
+private:
+    friend class UCapabilityManagerComponent;
+    friend class UCapabilitySchedulerSubsystem;
+    friend class UCapabilityTimerWheelSubsystem;
+
+    UPROPERTY(Transient)
+    UCapabilityManagerComponent* OwningManager = nullptr;
+
+    // Slot in the scheduler's per-class tick bucket while active, INDEX_NONE otherwise
+    int32 SchedulerBucketIndex = INDEX_NONE;
+    int32 SchedulerSlotIndex = INDEX_NONE;
+
+    // Another instance of the same class is active on the owner, so this one can't run in the same parallel wave
+    bool bSchedulerForceGameThread = false;
+
+    // A dependency changed since activation was last evaluated
+    bool bActivationDirty = false;
+
+    // Waiting in the scheduler's predicate batch of this class
+    bool bPredicateQueued = false;
+
+    // World time of the last deactivation for the predicate cooldown, and the timer re-checking event-driven capabilities
+    float LastDeactivationTime = -1.0f;
+    FTimerHandle CooldownTimerHandle;
+
+    // Copied from the class default object, so lookups never walk the class hierarchy
+    int32 CapabilityTypeId = INDEX_NONE;
+
+    // Tick LOD state
+    int32 CurrentTickLODLevel = INDEX_NONE;
+    int32 FramesSinceLODTick = 0;
+    float AccumulatedLODDeltaTime = 0.0f;
+
+    // DeltaTime handed to TickCapabilityConcurrent by the scheduler's parallel waves
+    float ScheduledDeltaTime = 0.0f;
+
+    // Sleep state - the serial changes whenever the sleep ends or is replaced, invalidating pending wake timers
+    bool bSleeping = false;
+    uint32 SleepSerial = 0;
+    FName SleepWakeEvent;
+
+    UPROPERTY(Transient)
+    UClass* SleepWakeComponentClass = nullptr;
 };
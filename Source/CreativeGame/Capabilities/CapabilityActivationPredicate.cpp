@@ -0,0 +1,269 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapabilityActivationPredicate.h"
+#include "BaseCapability.h"
+#include "CapabilityStats.h"
+#include "../Components/BaseComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "UObject/EnumProperty.h"
+#include "UObject/UObjectGlobals.h"
+#include "UObject/UnrealType.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Predicate Evaluations"), STAT_Capabilities_PredicateEvaluations, STATGROUP_Capabilities);
+
+TArray<TUniquePtr<FCapabilityPredicateProgram>> FCapabilityPredicateProgram::Programs;
+
+// Scratch shared by every evaluation, programs are only evaluated on the game thread
+static TArray<const uint8*> PredicateSlotMemory;
+static TArray<double> PredicateFieldValues;
+
+static bool ResolveFieldType(const FProperty* Property, FCapabilityPredicateInstruction& Instruction)
+{
+	Instruction.Offset = Property->GetOffset_ForInternal();
+
+	// Enums are compared by their underlying value, which starts at the enum property's offset
+	if (const FEnumProperty* EnumProperty = CastField<FEnumProperty>(Property))
+	{
+		Property = EnumProperty->GetUnderlyingProperty();
+	}
+
+	if (const FBoolProperty* BoolProperty = CastField<FBoolProperty>(Property))
+	{
+		Instruction.FieldType = ECapabilityPredicateFieldType::Bool;
+		Instruction.Offset += BoolProperty->GetByteOffset();
+		Instruction.BoolFieldMask = BoolProperty->GetFieldMask();
+		return true;
+	}
+
+	if (CastField<FByteProperty>(Property))
+	{
+		Instruction.FieldType = ECapabilityPredicateFieldType::UInt8;
+	}
+	else if (CastField<FIntProperty>(Property))
+	{
+		Instruction.FieldType = ECapabilityPredicateFieldType::Int32;
+	}
+	else if (CastField<FInt64Property>(Property))
+	{
+		Instruction.FieldType = ECapabilityPredicateFieldType::Int64;
+	}
+	else if (CastField<FFloatProperty>(Property))
+	{
+		Instruction.FieldType = ECapabilityPredicateFieldType::Float;
+	}
+	else if (CastField<FDoubleProperty>(Property))
+	{
+		Instruction.FieldType = ECapabilityPredicateFieldType::Double;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+template<typename T>
+static void GatherField(const FCapabilityPredicateInstruction& Instruction, int32 NumSlots, TArray<uint8>& Results)
+{
+	for (int32 Index = 0; Index < Results.Num(); ++Index)
+	{
+		const uint8* Memory = PredicateSlotMemory[Index * NumSlots + Instruction.Slot];
+		PredicateFieldValues[Index] = Memory ? static_cast<double>(*reinterpret_cast<const T*>(Memory + Instruction.Offset)) : 0.0;
+		Results[Index] &= Memory != nullptr;
+	}
+}
+
+static void GatherBoolField(const FCapabilityPredicateInstruction& Instruction, int32 NumSlots, TArray<uint8>& Results)
+{
+	for (int32 Index = 0; Index < Results.Num(); ++Index)
+	{
+		const uint8* Memory = PredicateSlotMemory[Index * NumSlots + Instruction.Slot];
+		PredicateFieldValues[Index] = Memory && (Memory[Instruction.Offset] & Instruction.BoolFieldMask) ? 1.0 : 0.0;
+		Results[Index] &= Memory != nullptr;
+	}
+}
+
+template<typename CompareType>
+static void CompareFieldValues(double Value, TArray<uint8>& Results, CompareType Compare)
+{
+	// No early outs, so the loop stays a straight compare-and-mask
+	for (int32 Index = 0; Index < Results.Num(); ++Index)
+	{
+		Results[Index] &= static_cast<uint8>(Compare(PredicateFieldValues[Index], Value));
+	}
+}
+
+const FCapabilityPredicateProgram* FCapabilityPredicateProgram::Get(const UBaseCapability* Capability)
+{
+	check(IsInGameThread());
+
+	const int32 TypeId = Capability ? Capability->GetCapabilityTypeId() : INDEX_NONE;
+	if (TypeId == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	// Programs hold component classes and property offsets, drop them whenever those may have gone stale
+	static bool bResetDelegatesBound = false;
+	if (!bResetDelegatesBound)
+	{
+		bResetDelegatesBound = true;
+		FWorldDelegates::OnWorldCleanup.AddLambda([](UWorld*, bool, bool) { ResetPrograms(); });
+		FCoreUObjectDelegates::OnObjectsReinstanced.AddLambda([](const TMap<UObject*, UObject*>&) { ResetPrograms(); });
+	}
+
+	if (TypeId >= Programs.Num())
+	{
+		Programs.SetNum(TypeId + 1);
+	}
+
+	TUniquePtr<FCapabilityPredicateProgram>& Program = Programs[TypeId];
+	if (!Program)
+	{
+		// The predicate is only editable on defaults, so every instance shares the class's program
+		const UBaseCapability* DefaultCapability = Capability->GetClass()->GetDefaultObject<UBaseCapability>();
+		Program = MakeUnique<FCapabilityPredicateProgram>();
+		Program->Compile(Capability->GetClass(), DefaultCapability->GetActivationPredicate());
+	}
+	return Program.Get();
+}
+
+void FCapabilityPredicateProgram::ResetPrograms()
+{
+	check(IsInGameThread());
+	Programs.Reset();
+}
+
+void FCapabilityPredicateProgram::Compile(const UClass* CapabilityClass, const FCapabilityActivationPredicate& Predicate)
+{
+	for (const FName& Tag : Predicate.RequiredTags)
+	{
+		FCapabilityPredicateInstruction& Instruction = Instructions.AddDefaulted_GetRef();
+		Instruction.Op = ECapabilityPredicateOp::HasTag;
+		Instruction.Tag = Tag;
+	}
+
+	for (const FName& Tag : Predicate.BlockedTags)
+	{
+		FCapabilityPredicateInstruction& Instruction = Instructions.AddDefaulted_GetRef();
+		Instruction.Op = ECapabilityPredicateOp::LacksTag;
+		Instruction.Tag = Tag;
+	}
+
+	for (const FCapabilityFieldCondition& Condition : Predicate.FieldConditions)
+	{
+		FCapabilityPredicateInstruction& Instruction = Instructions.AddDefaulted_GetRef();
+		Instruction.Comparison = Condition.Comparison;
+		Instruction.Value = Condition.Value;
+
+		UClass* ComponentClass = Condition.ComponentClass.Get();
+		if (!ComponentClass)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s: activation predicate compares %s without a component class, the condition never holds"),
+				*GetNameSafe(CapabilityClass), *Condition.FieldName.ToString());
+			continue;
+		}
+
+		// Component fields first, then the fragment the component stores its data in
+		bool bFragment = false;
+		const FProperty* Property = ComponentClass->FindPropertyByName(Condition.FieldName);
+		if (!Property)
+		{
+			const UScriptStruct* FragmentType = ComponentClass->GetDefaultObject<UBaseComponent>()->GetFragmentType();
+			Property = FragmentType ? FragmentType->FindPropertyByName(Condition.FieldName) : nullptr;
+			bFragment = Property != nullptr;
+		}
+
+		if (!Property || !ResolveFieldType(Property, Instruction))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s: activation predicate field %s.%s is missing or not a bool or number, the condition never holds"),
+				*GetNameSafe(CapabilityClass), *ComponentClass->GetName(), *Condition.FieldName.ToString());
+			continue;
+		}
+
+		Instruction.Op = ECapabilityPredicateOp::CompareField;
+		Instruction.Slot = FindOrAddSlot(ComponentClass, bFragment);
+	}
+}
+
+int32 FCapabilityPredicateProgram::FindOrAddSlot(UClass* ComponentClass, bool bFragment)
+{
+	const int32 Existing = Slots.IndexOfByPredicate([ComponentClass, bFragment](const FCapabilityPredicateSlot& Slot)
+	{
+		return Slot.ComponentClass == ComponentClass && Slot.bFragment == bFragment;
+	});
+	return Existing != INDEX_NONE ? Existing : Slots.Add({ ComponentClass, bFragment });
+}
+
+void FCapabilityPredicateProgram::Evaluate(TConstArrayView<UBaseCapability*> Capabilities, TArray<uint8>& OutResults) const
+{
+	check(IsInGameThread());
+
+	const int32 Num = Capabilities.Num();
+	OutResults.SetNumUninitialized(Num);
+	FMemory::Memset(OutResults.GetData(), 1, Num);
+	INC_DWORD_STAT_BY(STAT_Capabilities_PredicateEvaluations, Num);
+
+	// Resolve every component the program reads once per capability, instructions only index into this
+	const int32 NumSlots = Slots.Num();
+	PredicateSlotMemory.SetNumUninitialized(Num * NumSlots);
+	PredicateFieldValues.SetNumUninitialized(Num);
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		const AActor* Owner = Capabilities[Index]->GetOwner();
+		for (int32 SlotIndex = 0; SlotIndex < NumSlots; ++SlotIndex)
+		{
+			const FCapabilityPredicateSlot& Slot = Slots[SlotIndex];
+			const UBaseComponent* Component = Owner ? Cast<UBaseComponent>(Owner->FindComponentByClass(Slot.ComponentClass)) : nullptr;
+			const void* Memory = Component && Slot.bFragment ? Component->GetFragmentMemory() : Component;
+			PredicateSlotMemory[Index * NumSlots + SlotIndex] = static_cast<const uint8*>(Memory);
+		}
+	}
+
+	for (const FCapabilityPredicateInstruction& Instruction : Instructions)
+	{
+		switch (Instruction.Op)
+		{
+		case ECapabilityPredicateOp::HasTag:
+		case ECapabilityPredicateOp::LacksTag:
+		{
+			const bool bWantsTag = Instruction.Op == ECapabilityPredicateOp::HasTag;
+			for (int32 Index = 0; Index < Num; ++Index)
+			{
+				const AActor* Owner = Capabilities[Index]->GetOwner();
+				OutResults[Index] &= Owner && Owner->Tags.Contains(Instruction.Tag) == bWantsTag;
+			}
+			break;
+		}
+
+		case ECapabilityPredicateOp::CompareField:
+		{
+			switch (Instruction.FieldType)
+			{
+			case ECapabilityPredicateFieldType::Bool: GatherBoolField(Instruction, NumSlots, OutResults); break;
+			case ECapabilityPredicateFieldType::UInt8: GatherField<uint8>(Instruction, NumSlots, OutResults); break;
+			case ECapabilityPredicateFieldType::Int32: GatherField<int32>(Instruction, NumSlots, OutResults); break;
+			case ECapabilityPredicateFieldType::Int64: GatherField<int64>(Instruction, NumSlots, OutResults); break;
+			case ECapabilityPredicateFieldType::Float: GatherField<float>(Instruction, NumSlots, OutResults); break;
+			case ECapabilityPredicateFieldType::Double: GatherField<double>(Instruction, NumSlots, OutResults); break;
+			}
+
+			switch (Instruction.Comparison)
+			{
+			case ECapabilityPredicateComparison::Equal: CompareFieldValues(Instruction.Value, OutResults, [](double A, double B) { return A == B; }); break;
+			case ECapabilityPredicateComparison::NotEqual: CompareFieldValues(Instruction.Value, OutResults, [](double A, double B) { return A != B; }); break;
+			case ECapabilityPredicateComparison::Less: CompareFieldValues(Instruction.Value, OutResults, [](double A, double B) { return A < B; }); break;
+			case ECapabilityPredicateComparison::LessOrEqual: CompareFieldValues(Instruction.Value, OutResults, [](double A, double B) { return A <= B; }); break;
+			case ECapabilityPredicateComparison::Greater: CompareFieldValues(Instruction.Value, OutResults, [](double A, double B) { return A > B; }); break;
+			case ECapabilityPredicateComparison::GreaterOrEqual: CompareFieldValues(Instruction.Value, OutResults, [](double A, double B) { return A >= B; }); break;
+			}
+			break;
+		}
+
+		default:
+			FMemory::Memzero(OutResults.GetData(), Num);
+			break;
+		}
+	}
+}
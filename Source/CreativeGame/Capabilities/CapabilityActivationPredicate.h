@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/UniquePtr.h"
+
+class UBaseCapability;
+class UBaseComponent;
+
+#include "CapabilityActivationPredicate.generated.h"
+
+UENUM(BlueprintType)
+enum class ECapabilityPredicateComparison : uint8
+{
+	Equal,
+	NotEqual,
+	Less,
+	LessOrEqual,
+	Greater,
+	GreaterOrEqual
+};
+
+/**
+ * Compares a numeric or bool field of one of the owner's components with a constant.
+ * Fields of components storing their data as a fragment are looked up on the fragment struct.
+ */
+USTRUCT(BlueprintType)
+struct FCapabilityFieldCondition
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capabilities")
+	TSubclassOf<UBaseComponent> ComponentClass;
+
+	// bool, uint8/enum, int32, int64, float or double property - bools compare as 0 or 1
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capabilities")
+	FName FieldName;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capabilities")
+	ECapabilityPredicateComparison Comparison = ECapabilityPredicateComparison::Equal;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capabilities")
+	double Value = 0.0;
+};
+
+/**
+ * Declarative activation conditions of a capability class. The capability should be active while every condition holds,
+ * and may only activate again Cooldown seconds after it deactivated.
+ */
+USTRUCT(BlueprintType)
+struct FCapabilityActivationPredicate
+{
+	GENERATED_BODY()
+
+	// Owner actor tags that must all be present
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capabilities")
+	TArray<FName> RequiredTags;
+
+	// Owner actor tags that must all be absent
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capabilities")
+	TArray<FName> BlockedTags;
+
+	// Component fields that must all compare true, a missing component fails its condition
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capabilities")
+	TArray<FCapabilityFieldCondition> FieldConditions;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capabilities", meta = (ClampMin = "0", Units = "s"))
+	float Cooldown = 0.0f;
+};
+
+enum class ECapabilityPredicateOp : uint8
+{
+	HasTag,
+	LacksTag,
+	CompareField,
+
+	// Field couldn't be resolved when compiling, always fails
+	Fail
+};
+
+enum class ECapabilityPredicateFieldType : uint8
+{
+	Bool,
+	UInt8,
+	Int32,
+	Int64,
+	Float,
+	Double
+};
+
+/**
+ * One step of a compiled predicate, applied to every capability of a batch before the next step runs.
+ */
+struct FCapabilityPredicateInstruction
+{
+	ECapabilityPredicateOp Op = ECapabilityPredicateOp::Fail;
+	ECapabilityPredicateComparison Comparison = ECapabilityPredicateComparison::Equal;
+	ECapabilityPredicateFieldType FieldType = ECapabilityPredicateFieldType::Bool;
+
+	// Mask of the bit holding a bitfield bool
+	uint8 BoolFieldMask = 0xFF;
+
+	FName Tag;
+
+	// Index into the program's component slots and byte offset of the field in the slot's memory
+	int32 Slot = INDEX_NONE;
+	int32 Offset = 0;
+
+	double Value = 0.0;
+};
+
+/**
+ * Component memory read by a predicate program - the component itself, or its archetype fragment.
+ */
+struct FCapabilityPredicateSlot
+{
+	UClass* ComponentClass = nullptr;
+	bool bFragment = false;
+};
+
+/**
+ * A capability class's FCapabilityActivationPredicate flattened into instructions with field offsets resolved up front.
+ * Programs are compiled once per class, the first time an instance is evaluated, and dropped on world cleanup and
+ * class reinstancing so they never outlive the component classes and property offsets they were compiled against.
+ *
+ * Evaluate runs instruction by instruction over a whole batch of capabilities: component memory is resolved once per
+ * capability, then every field comparison gathers its values into a flat array and compares them in one tight loop.
+ */
+class CREATIVEGAME_API FCapabilityPredicateProgram
+{
+public:
+	// Compiled program of the capability's class, game thread only
+	static const FCapabilityPredicateProgram* Get(const UBaseCapability* Capability);
+
+	// OutResults[Index] is 1 when every condition holds for Capabilities[Index]. Cooldowns are left to the caller.
+	void Evaluate(TConstArrayView<UBaseCapability*> Capabilities, TArray<uint8>& OutResults) const;
+
+	int32 NumInstructions() const { return Instructions.Num(); }
+
+private:
+	void Compile(const UClass* CapabilityClass, const FCapabilityActivationPredicate& Predicate);
+	int32 FindOrAddSlot(UClass* ComponentClass, bool bFragment);
+	static void ResetPrograms();
+
+	TArray<FCapabilityPredicateInstruction> Instructions;
+	TArray<FCapabilityPredicateSlot> Slots;
+
+	static TArray<TUniquePtr<FCapabilityPredicateProgram>> Programs;
+};
@@ -0,0 +1,176 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapabilityDispatch.h"
+#include "BaseCapability.h"
+#include "CapabilityStats.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Script Event Calls"), STAT_Capabilities_ScriptEventCalls, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Native Event Calls"), STAT_Capabilities_NativeEventCalls, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Skipped Default Event Calls"), STAT_Capabilities_SkippedEventCalls, STATGROUP_Capabilities);
+
+static TAutoConsoleVariable<bool> CVarCapabilitiesDirectDispatch(
+	TEXT("ECS.Capabilities.DirectDispatch"),
+	true,
+	TEXT("Call capability events without a script override directly instead of through ProcessEvent, and skip them\n")
+	TEXT("entirely when only the UBaseCapability default exists."),
+	ECVF_Default);
+
+static FAutoConsoleCommand CapabilityDispatchReportCommand(
+	TEXT("ECS.Capabilities.DispatchReport"),
+	TEXT("Logs how TickCapability and the activation events of every capability class are called, and how often."),
+	FConsoleCommandDelegate::CreateStatic(&FCapabilityDispatch::LogReport));
+
+TArray<TUniquePtr<FCapabilityClassDispatch>> FCapabilityDispatch::Dispatches;
+
+static FName GetEventFunctionName(ECapabilityEvent Event)
+{
+	switch (Event)
+	{
+	case ECapabilityEvent::Tick: return GET_FUNCTION_NAME_CHECKED(UBaseCapability, TickCapability);
+	case ECapabilityEvent::ShouldBeActive: return GET_FUNCTION_NAME_CHECKED(UBaseCapability, ShouldBeActive);
+	case ECapabilityEvent::ShouldActivate: return GET_FUNCTION_NAME_CHECKED(UBaseCapability, ShouldActivate);
+	case ECapabilityEvent::ShouldDeactivate: return GET_FUNCTION_NAME_CHECKED(UBaseCapability, ShouldDeactivate);
+	default: return NAME_None;
+	}
+}
+
+static const TCHAR* GetPathName(ECapabilityDispatchPath Path)
+{
+	switch (Path)
+	{
+	case ECapabilityDispatchPath::Script: return TEXT("Script");
+	case ECapabilityDispatchPath::Native: return TEXT("Native");
+	case ECapabilityDispatchPath::SkippedDefault: return TEXT("Skipped");
+	default: return TEXT("Unknown");
+	}
+}
+
+FCapabilityClassDispatch* FCapabilityDispatch::FindOrAddDispatch(const UBaseCapability* Capability)
+{
+	check(IsInGameThread());
+
+	const int32 TypeId = Capability->GetCapabilityTypeId();
+	if (TypeId == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	if (TypeId >= Dispatches.Num())
+	{
+		Dispatches.SetNum(TypeId + 1);
+	}
+
+	TUniquePtr<FCapabilityClassDispatch>& Dispatch = Dispatches[TypeId];
+	if (!Dispatch)
+	{
+		const UClass* Class = Capability->GetClass();
+		Dispatch = MakeUnique<FCapabilityClassDispatch>();
+		Dispatch->ClassName = Class->GetName();
+
+		// Only UBaseCapability's own implementations can run if no native subclass sits between it and this class
+		const UClass* NativeClass = Class;
+		while (NativeClass && !NativeClass->HasAnyClassFlags(CLASS_Native))
+		{
+			NativeClass = NativeClass->GetSuperClass();
+		}
+		const bool bOnlyDefaultNative = NativeClass == UBaseCapability::StaticClass();
+
+		for (int32 EventIndex = 0; EventIndex < (int32)ECapabilityEvent::Num; ++EventIndex)
+		{
+			// Script overrides add a UFunction to the (non-native) class that overrides the event
+			const UFunction* Function = Class->FindFunctionByName(GetEventFunctionName((ECapabilityEvent)EventIndex));
+			const bool bScriptOverride = Function && !Function->GetOwnerClass()->HasAnyClassFlags(CLASS_Native);
+
+			Dispatch->Paths[EventIndex] = bScriptOverride ? ECapabilityDispatchPath::Script
+				: bOnlyDefaultNative ? ECapabilityDispatchPath::SkippedDefault
+				: ECapabilityDispatchPath::Native;
+		}
+	}
+
+	return Dispatch.Get();
+}
+
+ECapabilityDispatchPath FCapabilityDispatch::GetPath(const UBaseCapability* Capability, ECapabilityEvent Event)
+{
+	FCapabilityClassDispatch* Dispatch = CVarCapabilitiesDirectDispatch.GetValueOnGameThread() ? FindOrAddDispatch(Capability) : nullptr;
+	const ECapabilityDispatchPath Path = Dispatch ? Dispatch->Paths[(int32)Event] : ECapabilityDispatchPath::Script;
+
+	if (Dispatch)
+	{
+		++Dispatch->NumCalls[(int32)Event][(int32)Path];
+	}
+
+	switch (Path)
+	{
+	case ECapabilityDispatchPath::Script: INC_DWORD_STAT(STAT_Capabilities_ScriptEventCalls); break;
+	case ECapabilityDispatchPath::Native: INC_DWORD_STAT(STAT_Capabilities_NativeEventCalls); break;
+	default: INC_DWORD_STAT(STAT_Capabilities_SkippedEventCalls); break;
+	}
+
+	return Path;
+}
+
+void FCapabilityDispatch::TickCapability(UBaseCapability* Capability, float DeltaTime)
+{
+	switch (GetPath(Capability, ECapabilityEvent::Tick))
+	{
+	case ECapabilityDispatchPath::Script: Capability->TickCapability(DeltaTime); break;
+	case ECapabilityDispatchPath::Native: Capability->TickCapability_Implementation(DeltaTime); break;
+	default: break;
+	}
+}
+
+bool FCapabilityDispatch::ShouldBeActive(UBaseCapability* Capability)
+{
+	switch (GetPath(Capability, ECapabilityEvent::ShouldBeActive))
+	{
+	case ECapabilityDispatchPath::Script: return Capability->ShouldBeActive();
+	case ECapabilityDispatchPath::Native: return Capability->ShouldBeActive_Implementation();
+	default: return true;
+	}
+}
+
+bool FCapabilityDispatch::ShouldActivate(UBaseCapability* Capability)
+{
+	switch (GetPath(Capability, ECapabilityEvent::ShouldActivate))
+	{
+	case ECapabilityDispatchPath::Script: return Capability->ShouldActivate();
+	case ECapabilityDispatchPath::Native: return Capability->ShouldActivate_Implementation();
+	default: return true;
+	}
+}
+
+bool FCapabilityDispatch::ShouldDeactivate(UBaseCapability* Capability)
+{
+	switch (GetPath(Capability, ECapabilityEvent::ShouldDeactivate))
+	{
+	case ECapabilityDispatchPath::Script: return Capability->ShouldDeactivate();
+	case ECapabilityDispatchPath::Native: return Capability->ShouldDeactivate_Implementation();
+	default: return false;
+	}
+}
+
+void FCapabilityDispatch::LogReport()
+{
+	static const TCHAR* EventNames[] = { TEXT("Tick"), TEXT("ShouldBeActive"), TEXT("ShouldActivate"), TEXT("ShouldDeactivate") };
+	static_assert(UE_ARRAY_COUNT(EventNames) == (int32)ECapabilityEvent::Num, "Missing capability event name");
+
+	UE_LOG(LogTemp, Log, TEXT("Capability dispatch (DirectDispatch %s):"), CVarCapabilitiesDirectDispatch.GetValueOnGameThread() ? TEXT("on") : TEXT("off"));
+	for (const TUniquePtr<FCapabilityClassDispatch>& Dispatch : Dispatches)
+	{
+		if (!Dispatch)
+		{
+			continue;
+		}
+
+		FString Line;
+		for (int32 EventIndex = 0; EventIndex < (int32)ECapabilityEvent::Num; ++EventIndex)
+		{
+			const uint64* Calls = Dispatch->NumCalls[EventIndex];
+			Line += FString::Printf(TEXT(" %s=%s (script %llu, native %llu, skipped %llu)"), EventNames[EventIndex], GetPathName(Dispatch->Paths[EventIndex]),
+				Calls[(int32)ECapabilityDispatchPath::Script], Calls[(int32)ECapabilityDispatchPath::Native], Calls[(int32)ECapabilityDispatchPath::SkippedDefault]);
+		}
+		UE_LOG(LogTemp, Log, TEXT("  %s:%s"), *Dispatch->ClassName, *Line);
+	}
+}
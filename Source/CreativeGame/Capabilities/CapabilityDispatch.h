@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/UniquePtr.h"
+
+class UBaseCapability;
+
+// BlueprintNativeEvents of UBaseCapability called by managers and the scheduler
+enum class ECapabilityEvent : uint8
+{
+	Tick,
+	ShouldBeActive,
+	ShouldActivate,
+	ShouldDeactivate,
+	Num
+};
+
+// How a capability event is called
+enum class ECapabilityDispatchPath : uint8
+{
+	// Overridden in Blueprint or script, goes through ProcessEvent
+	Script,
+
+	// Native implementation called directly as a virtual function, skipping the thunk
+	Native,
+
+	// Only the UBaseCapability default exists, not called at all
+	SkippedDefault,
+
+	Num
+};
+
+/**
+ * Dispatch paths of one capability class, resolved once the first time an instance is called.
+ */
+struct FCapabilityClassDispatch
+{
+	FString ClassName;
+	ECapabilityDispatchPath Paths[(int32)ECapabilityEvent::Num];
+
+	// Calls made through each path, game thread only
+	uint64 NumCalls[(int32)ECapabilityEvent::Num][(int32)ECapabilityDispatchPath::Num] = {};
+};
+
+/**
+ * Calls the BlueprintNativeEvents of capabilities without paying for ProcessEvent when nothing overrides them in script.
+ *
+ * Script overrides are detected per class by looking for the event's UFunction on a non-native class. Without one,
+ * the _Implementation is called directly. Classes whose closest native class is UBaseCapability itself (Blueprint or
+ * script subclasses that don't override the event) can only have the default implementation, so the call is skipped
+ * and the default result is used. Native subclasses always get the direct call, C++ overrides can't be detected.
+ *
+ * "stat Capabilities" shows the calls per path, ECS.Capabilities.DispatchReport logs them per class.
+ * Set ECS.Capabilities.DirectDispatch 0 to always go through ProcessEvent.
+ */
+class CREATIVEGAME_API FCapabilityDispatch
+{
+public:
+	static void TickCapability(UBaseCapability* Capability, float DeltaTime);
+	static bool ShouldBeActive(UBaseCapability* Capability);
+	static bool ShouldActivate(UBaseCapability* Capability);
+	static bool ShouldDeactivate(UBaseCapability* Capability);
+
+	// Log the path and call counts of every class resolved so far
+	static void LogReport();
+
+private:
+	static FCapabilityClassDispatch* FindOrAddDispatch(const UBaseCapability* Capability);
+	static ECapabilityDispatchPath GetPath(const UBaseCapability* Capability, ECapabilityEvent Event);
+
+	static TArray<TUniquePtr<FCapabilityClassDispatch>> Dispatches;
+};
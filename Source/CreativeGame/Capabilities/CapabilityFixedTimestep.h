@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Accumulator turning variable frame times into a whole number of fixed steps.
+ * Time beyond MaxSubsteps steps is dropped, so a hitch costs at most MaxSubsteps steps instead of one huge step.
+ */
+struct FCapabilityFixedTimestep
+{
+	// Unsimulated time carried over to the next frame, always below one step
+	float Accumulator = 0.0f;
+
+	// Time dropped by the substep cap since the last call
+	float DroppedTime = 0.0f;
+
+	// Number of StepSeconds steps to run this frame
+	int32 Advance(float DeltaTime, float StepSeconds, int32 MaxSubsteps)
+	{
+		Accumulator += FMath::Max(DeltaTime, 0.0f);
+		int32 NumSteps = FMath::FloorToInt32(Accumulator / StepSeconds);
+		DroppedTime = 0.0f;
+
+		if (NumSteps > MaxSubsteps)
+		{
+			DroppedTime = (NumSteps - MaxSubsteps) * StepSeconds;
+			NumSteps = MaxSubsteps;
+		}
+
+		Accumulator = FMath::Max(Accumulator - (NumSteps * StepSeconds) - DroppedTime, 0.0f);
+		return NumSteps;
+	}
+
+	// How far between the last and the next step the frame is, for interpolating rendered state
+	float GetAlpha(float StepSeconds) const
+	{
+		return FMath::Clamp(Accumulator / StepSeconds, 0.0f, 1.0f);
+	}
+};
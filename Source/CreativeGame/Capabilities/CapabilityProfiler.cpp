@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapabilityProfiler.h"
+#include "BaseCapability.h"
+#include "CoreGlobals.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+UE_TRACE_CHANNEL_DEFINE(CapabilityChannel);
+
+CSV_DEFINE_CATEGORY(Capabilities, true);
+CSV_DEFINE_CATEGORY(CapabilityCounts, true);
+
+TArray<TUniquePtr<FCapabilityClassProfile>> FCapabilityProfiler::Profiles;
+uint64 FCapabilityProfiler::LastPublishedFrame = 0;
+
+static const TCHAR* GetPhaseName(ECapabilityProfilePhase Phase)
+{
+	switch (Phase)
+	{
+	case ECapabilityProfilePhase::Tick: return TEXT("Tick");
+	case ECapabilityProfilePhase::ActivationCheck: return TEXT("ActivationCheck");
+	case ECapabilityProfilePhase::Activate: return TEXT("Activate");
+	case ECapabilityProfilePhase::Deactivate: return TEXT("Deactivate");
+	case ECapabilityProfilePhase::Add: return TEXT("Add");
+	default: return TEXT("Unknown");
+	}
+}
+
+const FCapabilityClassProfile* FCapabilityProfiler::FindProfile(const UBaseCapability* Capability)
+{
+	const int32 TypeId = Capability ? Capability->GetCapabilityTypeId() : INDEX_NONE;
+	return Profiles.IsValidIndex(TypeId) ? Profiles[TypeId].Get() : nullptr;
+}
+
+FCapabilityClassProfile* FCapabilityProfiler::FindOrAddProfile(const UBaseCapability* Capability)
+{
+	check(IsInGameThread());
+
+	const int32 TypeId = Capability ? Capability->GetCapabilityTypeId() : INDEX_NONE;
+	if (TypeId == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	if (TypeId >= Profiles.Num())
+	{
+		Profiles.SetNum(TypeId + 1);
+	}
+
+	TUniquePtr<FCapabilityClassProfile>& Profile = Profiles[TypeId];
+	if (!Profile)
+	{
+		Profile = MakeUnique<FCapabilityClassProfile>();
+		Profile->ClassName = Capability->GetClass()->GetName();
+
+		for (int32 PhaseIndex = 0; PhaseIndex < (int32)ECapabilityProfilePhase::Num; ++PhaseIndex)
+		{
+			const FString PhaseName = FString::Printf(TEXT("%s %s"), *Profile->ClassName, GetPhaseName((ECapabilityProfilePhase)PhaseIndex));
+#if STATS
+			Profile->PhaseStatIds[PhaseIndex] = FDynamicStats::CreateStatId<FStatGroup_STATGROUP_Capabilities>(PhaseName);
+#endif
+#if CPUPROFILERTRACE_ENABLED
+			Profile->PhaseTraceSpecIds[PhaseIndex] = FCpuProfilerTrace::OutputEventType(*PhaseName);
+#endif
+			Profile->PhaseCsvNames[PhaseIndex] = FName(*PhaseName);
+		}
+
+#if STATS
+		Profile->NumInstancesStatId = FDynamicStats::CreateStatIdInt64<FStatGroup_STATGROUP_Capabilities>(Profile->ClassName + TEXT(" Count"));
+		Profile->NumActiveStatId = FDynamicStats::CreateStatIdInt64<FStatGroup_STATGROUP_Capabilities>(Profile->ClassName + TEXT(" Active"));
+#endif
+		Profile->NumActiveCsvName = FName(Profile->ClassName + TEXT(" Active"));
+	}
+
+	return Profile.Get();
+}
+
+void FCapabilityProfiler::NotifyAdded(const UBaseCapability* Capability)
+{
+	if (FCapabilityClassProfile* Profile = FindOrAddProfile(Capability))
+	{
+		++Profile->NumInstances;
+	}
+}
+
+void FCapabilityProfiler::NotifyRemoved(const UBaseCapability* Capability)
+{
+	if (FCapabilityClassProfile* Profile = FindOrAddProfile(Capability))
+	{
+		--Profile->NumInstances;
+	}
+}
+
+void FCapabilityProfiler::NotifyActivated(const UBaseCapability* Capability)
+{
+	if (FCapabilityClassProfile* Profile = FindOrAddProfile(Capability))
+	{
+		++Profile->NumActive;
+	}
+}
+
+void FCapabilityProfiler::NotifyDeactivated(const UBaseCapability* Capability)
+{
+	if (FCapabilityClassProfile* Profile = FindOrAddProfile(Capability))
+	{
+		--Profile->NumActive;
+	}
+}
+
+void FCapabilityProfiler::PublishCounts()
+{
+	// Every world's scheduler calls this, counts are global so once per frame is enough
+	if (LastPublishedFrame == GFrameCounter)
+	{
+		return;
+	}
+	LastPublishedFrame = GFrameCounter;
+
+	for (const TUniquePtr<FCapabilityClassProfile>& Profile : Profiles)
+	{
+		if (!Profile)
+		{
+			continue;
+		}
+
+#if STATS
+		FThreadStats::AddMessage(Profile->NumInstancesStatId.GetName(), EStatOperation::Set, int64(Profile->NumInstances));
+		FThreadStats::AddMessage(Profile->NumActiveStatId.GetName(), EStatOperation::Set, int64(Profile->NumActive));
+#endif
+#if CSV_PROFILER
+		FCsvProfiler::RecordCustomStat(Profile->NumActiveCsvName, CSV_CATEGORY_INDEX(CapabilityCounts), Profile->NumActive, ECsvCustomStatOp::Set);
+#endif
+	}
+}
+
+FCapabilityProfileScope::FCapabilityProfileScope(const UBaseCapability* Capability, ECapabilityProfilePhase InPhase)
+	: Profile(FCapabilityProfiler::FindProfile(Capability))
+	, Phase(InPhase)
+	, CycleCounter(Profile ? Profile->PhaseStatIds[(int32)InPhase] : TStatId())
+{
+	if (!Profile)
+	{
+		return;
+	}
+
+#if CPUPROFILERTRACE_ENABLED
+	if (UE_TRACE_CHANNELEXPR_IS_ENABLED(CapabilityChannel))
+	{
+		FCpuProfilerTrace::OutputBeginEvent(Profile->PhaseTraceSpecIds[(int32)Phase]);
+		bTraceEventStarted = true;
+	}
+#endif
+
+#if CSV_PROFILER
+	if (FCsvProfiler::Get()->IsCapturing())
+	{
+		FCsvProfiler::BeginStat(Profile->PhaseCsvNames[(int32)Phase], CSV_CATEGORY_INDEX(Capabilities));
+		bCsvStatStarted = true;
+	}
+#endif
+}
+
+FCapabilityProfileScope::~FCapabilityProfileScope()
+{
+#if CSV_PROFILER
+	if (bCsvStatStarted)
+	{
+		FCsvProfiler::EndStat(Profile->PhaseCsvNames[(int32)Phase], CSV_CATEGORY_INDEX(Capabilities));
+	}
+#endif
+
+#if CPUPROFILERTRACE_ENABLED
+	if (bTraceEventStarted)
+	{
+		FCpuProfilerTrace::OutputEndEvent();
+	}
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CapabilityStats.h"
+#include "Templates/UniquePtr.h"
+
+class UBaseCapability;
+
+// What a capability was doing while it was being profiled
+enum class ECapabilityProfilePhase : uint8
+{
+	Tick,
+	ActivationCheck,
+	Activate,
+	Deactivate,
+	Add,
+	Num
+};
+
+/**
+ * Profiling data of one capability class, created the first time an instance is added to a manager.
+ */
+struct FCapabilityClassProfile
+{
+	FString ClassName;
+
+	// Instances alive in all managers, and how many of them are active
+	int32 NumInstances = 0;
+	int32 NumActive = 0;
+
+	// One inclusive timer per phase, shown in "stat Capabilities" as "<Class> <Phase>"
+	TStatId PhaseStatIds[(int32)ECapabilityProfilePhase::Num];
+	TStatId NumInstancesStatId;
+	TStatId NumActiveStatId;
+
+	// Insights event types on CapabilityChannel and CSV stat names, one per phase
+	uint32 PhaseTraceSpecIds[(int32)ECapabilityProfilePhase::Num] = {};
+	FName PhaseCsvNames[(int32)ECapabilityProfilePhase::Num];
+	FName NumActiveCsvName;
+};
+
+/**
+ * Per capability class stats, Insights events and CSV timings.
+ * Class profiles are indexed by capability type id and never freed, so pointers to them stay valid.
+ *
+ * - "stat Capabilities" shows count, active count and inclusive ms of each phase per class
+ * - Insights shows the same scopes when tracing with -trace=cpu,CapabilityChannel
+ * - CSV captures get them in the Capabilities and CapabilityCounts categories
+ */
+class CREATIVEGAME_API FCapabilityProfiler
+{
+public:
+	// Read-only lookup, safe from the worker threads ticking capabilities
+	static const FCapabilityClassProfile* FindProfile(const UBaseCapability* Capability);
+
+	// Instance bookkeeping - game thread only
+	static void NotifyAdded(const UBaseCapability* Capability);
+	static void NotifyRemoved(const UBaseCapability* Capability);
+	static void NotifyActivated(const UBaseCapability* Capability);
+	static void NotifyDeactivated(const UBaseCapability* Capability);
+
+	// Push per-class counts to stats and CSV, at most once per frame
+	static void PublishCounts();
+
+private:
+	static FCapabilityClassProfile* FindOrAddProfile(const UBaseCapability* Capability);
+
+	static TArray<TUniquePtr<FCapabilityClassProfile>> Profiles;
+	static uint64 LastPublishedFrame;
+};
+
+/**
+ * Stat, trace and CSV scope of one capability class phase, does nothing for capabilities that were never added.
+ */
+class CREATIVEGAME_API FCapabilityProfileScope
+{
+public:
+	FCapabilityProfileScope(const UBaseCapability* Capability, ECapabilityProfilePhase Phase);
+	~FCapabilityProfileScope();
+
+private:
+	const FCapabilityClassProfile* Profile;
+	ECapabilityProfilePhase Phase;
+	FScopeCycleCounter CycleCounter;
+	bool bTraceEventStarted = false;
+	bool bCsvStatStarted = false;
+};
+
+#define CAPABILITY_PROFILE_SCOPE(Capability, Phase) \
+	FCapabilityProfileScope PREPROCESSOR_JOIN(CapabilityProfileScope_, __LINE__)(Capability, ECapabilityProfilePhase::Phase)
\ No newline at end of file
@@ -0,0 +1,13 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+
+// Shared stat group for the capability framework - view in game with "stat Capabilities"
+DECLARE_STATS_GROUP(TEXT("Capabilities"), STATGROUP_Capabilities, STATCAT_Advanced);
+
+// Insights channel for the per-class capability scopes - enable with -trace=cpu,CapabilityChannel
+UE_TRACE_CHANNEL_EXTERN(CapabilityChannel, CREATIVEGAME_API);
\ No newline at end of file
@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoroutineCapability.h"
+#include "../Components/CapabilityManagerComponent.h"
+#include "../Subsystems/CapabilityCoroutineSubsystem.h"
+
+void* FCapabilityTask::promise_type::AllocateFrame(const UCoroutineCapability& Capability, std::size_t Size)
+{
+	return FCapabilityCoroutineArena::AllocateFrame(Capability.GetWorld(), Size);
+}
+
+void FCapabilityTask::promise_type::operator delete(void* Frame, std::size_t Size)
+{
+	FCapabilityCoroutineArena::FreeFrame(Frame, Size);
+}
+
+FCapabilityTask& FCapabilityTask::operator=(FCapabilityTask&& Other)
+{
+	if (this != &Other)
+	{
+		Reset();
+		Handle = Other.Handle;
+		Other.Handle = nullptr;
+	}
+	return *this;
+}
+
+void FCapabilityTask::Resume()
+{
+	if (Handle && !Handle.done())
+	{
+		Handle.resume();
+	}
+}
+
+void FCapabilityTask::Reset()
+{
+	if (Handle)
+	{
+		Handle.destroy();
+		Handle = nullptr;
+	}
+}
+
+void FCapabilitySleepAwaiter::await_suspend(std::coroutine_handle<>) const
+{
+	// Resumed by the first tick after the manager wakes the capability
+	UCapabilityManagerComponent* Manager = Capability->GetOwningManager();
+	if (!Manager)
+	{
+		return;
+	}
+
+	if (ComponentClass)
+	{
+		Manager->SleepCapabilityUntilComponentChanged(Capability, ComponentClass, Seconds);
+	}
+	else
+	{
+		Manager->SleepCapabilityFor(Capability, Seconds);
+	}
+}
+
+void UCoroutineCapability::TickCapability_Implementation(float DeltaTime)
+{
+	if (Task.IsDone())
+	{
+		return;
+	}
+
+	LatentDeltaTime = DeltaTime;
+	Task.Resume();
+
+	// Nothing left to run, sleep until deactivated
+	if (Task.IsDone())
+	{
+		Task.Reset();
+		if (UCapabilityManagerComponent* Manager = GetOwningManager())
+		{
+			Manager->SleepCapabilityUntilEvent(this, NAME_None);
+		}
+	}
+}
+
+void UCoroutineCapability::OnCapabilityActivated_Implementation()
+{
+	Super::OnCapabilityActivated_Implementation();
+
+	Task = RunCapability();
+}
+
+void UCoroutineCapability::OnCapabilityDeactivated_Implementation()
+{
+	Task.Reset();
+
+	Super::OnCapabilityDeactivated_Implementation();
+}
+
+void UCoroutineCapability::BeginDestroy()
+{
+	Task.Reset();
+
+	Super::BeginDestroy();
+}
\ No newline at end of file
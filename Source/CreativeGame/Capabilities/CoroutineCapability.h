@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BaseCapability.h"
+#include <coroutine>
+#include <type_traits>
+
+class UCoroutineCapability;
+
+#include "CoroutineCapability.generated.h"
+
+/**
+ * Coroutine returned by UCoroutineCapability::RunCapability. Move-only, destroying it destroys the coroutine frame.
+ * Frames are allocated from the world's FCapabilityCoroutineArena.
+ */
+class CREATIVEGAME_API FCapabilityTask
+{
+public:
+	struct promise_type
+	{
+		// Only member coroutines of coroutine capabilities are allowed, the frame is allocated from their world's arena
+		template<typename CapabilityType, typename... ArgTypes>
+		static void* operator new(std::size_t Size, CapabilityType& Capability, ArgTypes&...)
+		{
+			static_assert(std::is_base_of_v<UCoroutineCapability, CapabilityType>, "FCapabilityTask coroutines must be members of a UCoroutineCapability");
+			return AllocateFrame(Capability, Size);
+		}
+
+		static void operator delete(void* Frame, std::size_t Size);
+
+		FCapabilityTask get_return_object() { return FCapabilityTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+
+		// Started by the first TickCapability after activation
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { checkNoEntry(); }
+
+	private:
+		static void* AllocateFrame(const UCoroutineCapability& Capability, std::size_t Size);
+	};
+
+	FCapabilityTask() = default;
+	FCapabilityTask(FCapabilityTask&& Other) : Handle(Other.Handle) { Other.Handle = nullptr; }
+	FCapabilityTask& operator=(FCapabilityTask&& Other);
+	FCapabilityTask(const FCapabilityTask&) = delete;
+	FCapabilityTask& operator=(const FCapabilityTask&) = delete;
+	~FCapabilityTask() { Reset(); }
+
+	bool IsValid() const { return static_cast<bool>(Handle); }
+	bool IsDone() const { return !Handle || Handle.done(); }
+
+	// Run until the next co_await or the end of the coroutine
+	void Resume();
+
+	// Destroy the coroutine frame, wherever it is suspended
+	void Reset();
+
+private:
+	explicit FCapabilityTask(std::coroutine_handle<promise_type> InHandle) : Handle(InHandle) {}
+
+	std::coroutine_handle<promise_type> Handle;
+};
+
+// co_await NextTick() - resume on the capability's next tick
+struct FCapabilityNextTickAwaiter
+{
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<>) const noexcept {}
+	void await_resume() const noexcept {}
+};
+
+// co_await Seconds(X) or ComponentChanged<T>() - the capability sleeps through its manager and doesn't tick until woken
+struct CREATIVEGAME_API FCapabilitySleepAwaiter
+{
+	UCoroutineCapability* Capability = nullptr;
+	float Seconds = -1.0f;
+	UClass* ComponentClass = nullptr;
+
+	bool await_ready() const noexcept { return !ComponentClass && Seconds <= 0.0f; }
+	void await_suspend(std::coroutine_handle<>) const;
+	void await_resume() const noexcept {}
+};
+
+/**
+ * Capability whose behaviour is written as a C++20 coroutine instead of a state machine in TickCapability:
+ *
+ *   FCapabilityTask UMyCapability::RunCapability()
+ *   {
+ *       co_await Seconds(2.0f);
+ *       while (true)
+ *       {
+ *           co_await ComponentChanged<UHealthComponent>();
+ *           ...
+ *           co_await NextTick();
+ *       }
+ *   }
+ *
+ * RunCapability starts when the capability activates and is destroyed when it deactivates. While waiting on Seconds
+ * or ComponentChanged the capability sleeps (see UCapabilityManagerComponent::SleepCapabilityFor) and costs nothing
+ * per frame. A coroutine that returns leaves the capability asleep until it deactivates.
+ */
+UCLASS(Abstract)
+class CREATIVEGAME_API UCoroutineCapability : public UBaseCapability
+{
+	GENERATED_BODY()
+
+public:
+	virtual void TickCapability_Implementation(float DeltaTime) override;
+	virtual void BeginDestroy() override;
+
+	// DeltaTime of the tick the coroutine was last resumed in
+	float GetLatentDeltaTime() const { return LatentDeltaTime; }
+
+protected:
+	virtual void OnCapabilityActivated_Implementation() override;
+	virtual void OnCapabilityDeactivated_Implementation() override;
+
+	// The capability's behaviour, override as a coroutine
+	virtual FCapabilityTask RunCapability() { return FCapabilityTask(); }
+
+	// Awaitables for RunCapability
+	FCapabilityNextTickAwaiter NextTick() const { return FCapabilityNextTickAwaiter(); }
+	FCapabilitySleepAwaiter Seconds(float Duration) { return FCapabilitySleepAwaiter{ this, Duration, nullptr }; }
+
+	template<typename T>
+	FCapabilitySleepAwaiter ComponentChanged() { return FCapabilitySleepAwaiter{ this, -1.0f, T::StaticClass() }; }
+
+private:
+	friend struct FCapabilitySleepAwaiter;
+
+	FCapabilityTask Task;
+	float LatentDeltaTime = 0.0f;
+};
\ No newline at end of file
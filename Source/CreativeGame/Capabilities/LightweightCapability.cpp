@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LightweightCapability.h"
+#include "../Components/CapabilityManagerComponent.h"
+
+AActor* ULightweightCapability::GetOwner() const
+{
+	return OwningManager ? OwningManager->GetOwner() : nullptr;
+}
+
+UWorld* ULightweightCapability::GetWorld() const
+{
+	// The class default object has no manager, returning null tells the editor it has no world context
+	return OwningManager ? OwningManager->GetWorld() : nullptr;
+}
+
+bool ULightweightCapability::ShouldBeActive_Implementation()
+{
+	return true;
+}
+
+bool ULightweightCapability::ShouldDeactivate_Implementation()
+{
+	return false;
+}
+
+bool ULightweightCapability::ShouldActivate_Implementation()
+{
+	return true;
+}
+
+void ULightweightCapability::TickCapability_Implementation(float DeltaTime)
+{
+}
+
+void ULightweightCapability::OnCapabilityActivated_Implementation()
+{
+}
+
+void ULightweightCapability::OnCapabilityDeactivated_Implementation()
+{
+}
@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+
+class UCapabilityManagerComponent;
+
+#include "LightweightCapability.generated.h"
+
+/**
+ * Capability that is a plain UObject owned by its manager instead of an actor component.
+ * It keeps the ShouldBeActive/ShouldActivate/ShouldDeactivate/TickCapability contract of UBaseCapability, but is never
+ * registered, has no tick function and doesn't take a slot in the owner's OwnedComponents, which makes it much cheaper
+ * to create for actors carrying many capabilities.
+ *
+ * Lightweight capabilities are always polled and ticked on the game thread, in priority order after the manager's
+ * component capabilities. Use UBaseCapability for event-driven activation, tick LOD, worker-thread ticking or pooling.
+ */
+UCLASS(Abstract, BlueprintType, Blueprintable)
+class CREATIVEGAME_API ULightweightCapability : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	// State management - override these for custom activation logic
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Capabilities")
+	bool ShouldBeActive();
+
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Capabilities")
+	bool ShouldDeactivate();
+
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Capabilities")
+	bool ShouldActivate();
+
+	// Called by the manager while the capability is active
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Capabilities")
+	void TickCapability(float DeltaTime);
+
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	bool IsActive() const { return bIsActive; }
+
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	int32 GetPriority() const { return Priority; }
+
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	UCapabilityManagerComponent* GetOwningManager() const { return OwningManager; }
+
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	AActor* GetOwner() const;
+
+	// Lets Blueprint subclasses call world-context functions
+	virtual UWorld* GetWorld() const override;
+
+protected:
+	// Called when capability is activated - override for custom behavior
+	UFUNCTION(BlueprintNativeEvent, Category = "Capabilities")
+	void OnCapabilityActivated();
+
+	// Called when capability is deactivated - override for custom behavior
+	UFUNCTION(BlueprintNativeEvent, Category = "Capabilities")
+	void OnCapabilityDeactivated();
+
+	// Read when the capability is added, higher priority ticks first
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Capability Settings")
+	int32 Priority = 0;
+
+private:
+	friend class UCapabilityManagerComponent;
+
+	UPROPERTY(Transient)
+	UCapabilityManagerComponent* OwningManager = nullptr;
+
+	bool bIsActive = false;
+};
@@ -1,4 +1,7 @@
 #include "BaseComponent.h"
+#include "../Subsystems/ECSArchetypeSubsystem.h"
+#include "CapabilityManagerComponent.h"
+#include "GameFramework/Actor.h"
 
 UBaseComponent::UBaseComponent()
 {
@@ -16,4 +19,106 @@ void UBaseComponent::BeginPlay()
 	
 	// Ensure we never accidentally start ticking
 	SetComponentTickEnabled(false);
+
+	// Opted into archetype storage - the data lives in the world's store, this component is just a handle
+	if (FragmentType)
+	{
+		ArchetypeStore = UECSArchetypeSubsystem::Get(this);
+		if (ArchetypeStore)
+		{
+			Entity = ArchetypeStore->AddFragment(GetOwner(), FragmentType);
+		}
+	}
+}
+
+void UBaseComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ArchetypeStore)
+	{
+		ArchetypeStore->RemoveFragment(Entity, FragmentType);
+		ArchetypeStore = nullptr;
+		Entity = FECSEntityHandle();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void* UBaseComponent::GetFragmentMemory() const
+{
+	return ArchetypeStore ? ArchetypeStore->GetFragmentMemory(Entity, FragmentType) : nullptr;
+}
+
+bool UBaseComponent::CopyFragmentTo(const UScriptStruct* StructType, void* Dest) const
+{
+	const void* Fragment = GetFragmentMemory();
+	if (!Fragment || !Dest || StructType != FragmentType)
+	{
+		return false;
+	}
+
+	FragmentType->CopyScriptStruct(Dest, Fragment);
+	return true;
+}
+
+bool UBaseComponent::CopyFragmentFrom(const UScriptStruct* StructType, const void* Source)
+{
+	void* Fragment = GetFragmentMemory();
+	if (!Fragment || !Source || StructType != FragmentType)
+	{
+		return false;
+	}
+
+	FragmentType->CopyScriptStruct(Fragment, Source);
+	MarkFieldChanged();
+	return true;
+}
+
+DEFINE_FUNCTION(UBaseComponent::execGetFragmentData)
+{
+	// Wildcard struct parameter, resolve its actual type from the property the VM stepped over
+	Stack.MostRecentPropertyAddress = nullptr;
+	Stack.MostRecentProperty = nullptr;
+	Stack.StepCompiledIn<FStructProperty>(nullptr);
+	void* OutFragment = Stack.MostRecentPropertyAddress;
+	const FStructProperty* StructProperty = CastField<FStructProperty>(Stack.MostRecentProperty);
+	P_FINISH;
+
+	P_NATIVE_BEGIN;
+	*(bool*)RESULT_PARAM = P_THIS->CopyFragmentTo(StructProperty ? StructProperty->Struct : nullptr, OutFragment);
+	P_NATIVE_END;
+}
+
+DEFINE_FUNCTION(UBaseComponent::execSetFragmentData)
+{
+	Stack.MostRecentPropertyAddress = nullptr;
+	Stack.MostRecentProperty = nullptr;
+	Stack.StepCompiledIn<FStructProperty>(nullptr);
+	const void* Fragment = Stack.MostRecentPropertyAddress;
+	const FStructProperty* StructProperty = CastField<FStructProperty>(Stack.MostRecentProperty);
+	P_FINISH;
+
+	P_NATIVE_BEGIN;
+	*(bool*)RESULT_PARAM = P_THIS->CopyFragmentFrom(StructProperty ? StructProperty->Struct : nullptr, Fragment);
+	P_NATIVE_END;
 }
+
+void UBaseComponent::MarkFieldChanged(FName FieldName)
+{
+	UCapabilityManagerComponent* Manager = CachedCapabilityManager.Get();
+	if (!Manager)
+	{
+		AActor* Owner = GetOwner();
+		Manager = Owner ? Owner->FindComponentByClass<UCapabilityManagerComponent>() : nullptr;
+
+		// Only the game thread fills the cache, worker-thread capabilities may be writing other fields of this component
+		if (IsInGameThread())
+		{
+			CachedCapabilityManager = Manager;
+		}
+	}
+
+	if (Manager)
+	{
+		Manager->NotifyComponentChanged(this, FieldName);
+	}
+}
\ No newline at end of file
@@ -4,12 +4,19 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "ECSFragment.h"
+
+class UCapabilityManagerComponent;
+class UECSArchetypeSubsystem;
 
 #include "BaseComponent.generated.h"
 
 /**
  * Base component class that serves as a pure data container.
  * Components should NEVER tick and only store data that capabilities can access and modify.
+ *
+ * Components that set FragmentType keep their data as a fragment in the world's archetype store instead,
+ * and act as a thin handle to it - use GetFragment<T>() from C++ or Get/SetFragmentData from Blueprint.
  */
 UCLASS(BlueprintType, Blueprintable, meta = (BlueprintSpawnableComponent))
 class CREATIVEGAME_API UBaseComponent : public UActorComponent
@@ -19,9 +26,41 @@ class CREATIVEGAME_API UBaseComponent : public UActorComponent
 public:
 	UBaseComponent();
 
+	// Tell the owner's capability manager that data changed, so event-driven capabilities depending on it re-check activation.
+	// Pass the changed field's name, or leave it empty when several fields changed.
+	UFUNCTION(BlueprintCallable, Category = "Component Data")
+	void MarkFieldChanged(FName FieldName = NAME_None);
+
+	// Archetype storage - the fragment is only valid until the next fragment is added or removed in the world
+	UScriptStruct* GetFragmentType() const { return FragmentType; }
+	FECSEntityHandle GetEntity() const { return Entity; }
+	void* GetFragmentMemory() const;
+
+	template<typename T>
+	T* GetFragment() const
+	{
+		return FragmentType && FragmentType->IsChildOf(T::StaticStruct()) ? static_cast<T*>(GetFragmentMemory()) : nullptr;
+	}
+
+	// Copy the fragment out to a struct of the same type, returns false if the types don't match or there is no fragment
+	UFUNCTION(BlueprintCallable, CustomThunk, Category = "Component Data", meta = (CustomStructureParam = "OutFragment"))
+	bool GetFragmentData(int32& OutFragment) const;
+
+	// Overwrite the fragment with a struct of the same type and notify dependent capabilities
+	UFUNCTION(BlueprintCallable, CustomThunk, Category = "Component Data", meta = (CustomStructureParam = "Fragment"))
+	bool SetFragmentData(const int32& Fragment);
+
+	DECLARE_FUNCTION(execGetFragmentData);
+	DECLARE_FUNCTION(execSetFragmentData);
+
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Optional USTRUCT (derived from FECSFragment) to store this component's data in the archetype store
+	UPROPERTY(EditDefaultsOnly, Category = "Component Data|Storage", meta = (MetaStruct = "/Script/CreativeGame.ECSFragment"))
+	UScriptStruct* FragmentType = nullptr;
 
 public:
 	// Optional: Add common data that all components might need
@@ -30,4 +69,16 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Component Data", meta = (MultiLine = true))
 	FString Description;
+
+private:
+	// Owner's capability manager, looked up on the first change notification
+	TWeakObjectPtr<UCapabilityManagerComponent> CachedCapabilityManager;
+
+	bool CopyFragmentTo(const UScriptStruct* StructType, void* Dest) const;
+	bool CopyFragmentFrom(const UScriptStruct* StructType, const void* Source);
+
+	UPROPERTY(Transient)
+	UECSArchetypeSubsystem* ArchetypeStore = nullptr;
+
+	FECSEntityHandle Entity;
 };
@@ -2,7 +2,85 @@
 
 #include "CapabilityManagerComponent.h"
 #include "../Capabilities/BaseCapability.h"  // Use relative path that works
+#include "../Capabilities/CapabilityActivationPredicate.h"
+#include "../Capabilities/CapabilityDispatch.h"
+#include "../Capabilities/CapabilityProfiler.h"
+#include "../Capabilities/CapabilityStats.h"
+#include "../Capabilities/LightweightCapability.h"
+#include "../Subsystems/CapabilityPoolSubsystem.h"
+#include "../Subsystems/CapabilitySchedulerSubsystem.h"
+#include "../Subsystems/CapabilityTimerWheelSubsystem.h"
+#include "Algo/BinarySearch.h"
+#include "BaseComponent.h"
+#include "CoreGlobals.h"
 #include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "TimerManager.h"
+
+static TAutoConsoleVariable<bool> CVarCapabilitiesForcePolling(
+	TEXT("ECS.Capabilities.ForcePollingActivation"),
+	false,
+	TEXT("Treat every capability as polled, re-checking activation every CapabilityUpdateFrequency even when it is event-driven.\n")
+	TEXT("Fallback for tracking down capabilities with missing activation dependencies."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarCapabilitiesActivationChecksPerFrame(
+	TEXT("ECS.Capabilities.ActivationChecksPerFrame"),
+	256,
+	TEXT("Maximum number of managers running their periodic activation check in one frame, 0 for no limit.\n")
+	TEXT("Checks over budget are postponed to the next frame instead of hitching this one."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<bool> CVarCapabilitiesTickLOD(
+	TEXT("ECS.LOD.Enabled"),
+	true,
+	TEXT("When enabled, capabilities with TickLODLevels tick less often (or not at all) far away from every player viewpoint."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarCapabilitiesLODDistanceUpdateInterval(
+	TEXT("ECS.LOD.DistanceUpdateInterval"),
+	0.25f,
+	TEXT("Seconds between refreshes of a manager's distance to the closest player viewpoint."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<bool> CVarCapabilitiesFixedStep(
+	TEXT("ECS.FixedStep.Enabled"),
+	false,
+	TEXT("Tick every capability in fixed steps of 1 / ECS.FixedStep.Hz seconds instead of with the frame's DeltaTime,\n")
+	TEXT("for reproducible server and benchmark runs. Managers with bUseFixedTimestep keep their own rate."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarCapabilitiesFixedStepHz(
+	TEXT("ECS.FixedStep.Hz"),
+	60.0f,
+	TEXT("Rate of the global fixed timestep."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarCapabilitiesFixedStepMaxSubsteps(
+	TEXT("ECS.FixedStep.MaxSubsteps"),
+	4,
+	TEXT("Fixed steps run at most per frame, time beyond that is dropped instead of catching up."),
+	ECVF_Default);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fixed Steps"), STAT_Capabilities_FixedSteps, STATGROUP_Capabilities);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Fixed Step Dropped Time (ms)"), STAT_Capabilities_FixedStepDroppedMs, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOD Skipped Ticks"), STAT_Capabilities_LODSkippedTicks, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Activation Checks"), STAT_Capabilities_ActivationChecks, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Activation Checks Deferred"), STAT_Capabilities_ActivationChecksDeferred, STATGROUP_Capabilities);
+DECLARE_CYCLE_STAT(TEXT("Lightweight Capability Tick"), STAT_Capabilities_LightweightTick, STATGROUP_Capabilities);
+
+// Golden ratio increments give every new manager a phase as far as possible from all previous ones
+static constexpr float ActivationPhaseStep = 0.61803398875f;
+static float NextActivationPhase = 0.0f;
+
+// Periodic activation checks run so far in the current frame, shared by every manager in every world
+static uint64 ActivationCheckBudgetFrame = 0;
+static int32 ActivationChecksThisFrame = 0;
+
+// Result of single-capability predicate checks on managers without a scheduler, activation is only updated on the game thread
+static TArray<uint8> SinglePredicateResult;
 
 UCapabilityManagerComponent::UCapabilityManagerComponent()
 {
@@ -11,198 +89,1122 @@ UCapabilityManagerComponent::UCapabilityManagerComponent()
 	PrimaryComponentTick.bStartWithTickEnabled = false;
 }
 
-void UCapabilityManagerComponent::BeginPlay()
+void UCapabilityManagerComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SetCountedByProfiler(true);
+
+	// Spread periodic activation checks of managers that begin play together over the whole update period
+	ActivationPhase = NextActivationPhase;
+	NextActivationPhase = FMath::Frac(NextActivationPhase + ActivationPhaseStep);
+	if (const UWorld* World = GetWorld())
+	{
+		LastCapabilityUpdateTime = World->GetTimeSeconds() - (1.0f - ActivationPhase) * CapabilityUpdateFrequency;
+	}
+
+	// Hand ticking over to the world scheduler before any capability activates
+	if (bUseCapabilityScheduler && !bUseFixedTimestep)
+	{
+		if (UWorld* World = GetWorld())
+		{
+			Scheduler = World->GetSubsystem<UCapabilitySchedulerSubsystem>();
+			if (Scheduler)
+			{
+				Scheduler->RegisterManager(this);
+			}
+		}
+	}
+	
+	// Initialize any capabilities that should start active
+	UpdateCapabilityStates();
+	
+	// Always disable auto-ticking since we use manual ticking
+	SetComponentTickEnabled(false);
+}
+
+void UCapabilityManagerComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (Scheduler)
+	{
+		Scheduler->UnregisterManager(this);
+		Scheduler = nullptr;
+	}
+
+	// Capabilities destroyed along with their owner never go through RemoveCapability
+	SetCountedByProfiler(false);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UCapabilityManagerComponent::SetCountedByProfiler(bool bCounted)
+{
+	if (bCountedByProfiler == bCounted)
+	{
+		return;
+	}
+	bCountedByProfiler = bCounted;
+
+	for (const UBaseCapability* Capability : Capabilities)
+	{
+		if (!Capability)
+		{
+			continue;
+		}
+
+		const bool bActive = ActiveCapabilities.Contains(Capability) || Capability->IsSleeping();
+		if (bCounted)
+		{
+			FCapabilityProfiler::NotifyAdded(Capability);
+			if (bActive)
+			{
+				FCapabilityProfiler::NotifyActivated(Capability);
+			}
+		}
+		else
+		{
+			if (bActive)
+			{
+				FCapabilityProfiler::NotifyDeactivated(Capability);
+			}
+			FCapabilityProfiler::NotifyRemoved(Capability);
+		}
+	}
+}
+
+void UCapabilityManagerComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	
+	ManualTick(DeltaTime);
+}
+
+void UCapabilityManagerComponent::ManualTick(float DeltaTime)
+{
+	// Only get time once per frame instead of every call
+	PreTickCapabilities(GetWorld()->GetTimeSeconds());
+
+	if (!IsFixedTimestep())
+	{
+		TickActiveCapabilities(DeltaTime);
+		PostTickCapabilities();
+		return;
+	}
+
+	float StepSeconds = 0.0f;
+	int32 MaxSubsteps = 0;
+	GetFixedTimestep(StepSeconds, MaxSubsteps);
+
+	const int32 NumSteps = FixedTimestep.Advance(DeltaTime, StepSeconds, MaxSubsteps);
+	INC_DWORD_STAT_BY(STAT_Capabilities_FixedSteps, NumSteps);
+	INC_FLOAT_STAT_BY(STAT_Capabilities_FixedStepDroppedMs, FixedTimestep.DroppedTime * 1000.0f);
+
+	for (int32 Step = 0; Step < NumSteps; ++Step)
+	{
+		// Every step sees the activation changes made by the previous one
+		if (Step > 0)
+		{
+			bIsCurrentlyTicking = false;
+			RunPendingActivationUpdates();
+			bIsCurrentlyTicking = true;
+		}
+
+		TickActiveCapabilities(StepSeconds);
+	}
+
+	PostTickCapabilities();
+}
+
+bool UCapabilityManagerComponent::IsFixedTimestep() const
+{
+	float StepSeconds = 0.0f;
+	int32 MaxSubsteps = 0;
+	return bUseFixedTimestep || GetGlobalFixedTimestep(StepSeconds, MaxSubsteps);
+}
+
+float UCapabilityManagerComponent::GetInterpolationAlpha() const
+{
+	if (bTickedByScheduler && Scheduler)
+	{
+		return Scheduler->GetInterpolationAlpha();
+	}
+
+	if (!IsFixedTimestep())
+	{
+		return 1.0f;
+	}
+
+	float StepSeconds = 0.0f;
+	int32 MaxSubsteps = 0;
+	GetFixedTimestep(StepSeconds, MaxSubsteps);
+	return FixedTimestep.GetAlpha(StepSeconds);
+}
+
+bool UCapabilityManagerComponent::GetGlobalFixedTimestep(float& OutStepSeconds, int32& OutMaxSubsteps)
+{
+	OutStepSeconds = 1.0f / FMath::Max(CVarCapabilitiesFixedStepHz.GetValueOnGameThread(), 1.0f);
+	OutMaxSubsteps = FMath::Max(CVarCapabilitiesFixedStepMaxSubsteps.GetValueOnGameThread(), 1);
+	return CVarCapabilitiesFixedStep.GetValueOnGameThread();
+}
+
+void UCapabilityManagerComponent::GetFixedTimestep(float& OutStepSeconds, int32& OutMaxSubsteps) const
+{
+	if (!bUseFixedTimestep)
+	{
+		GetGlobalFixedTimestep(OutStepSeconds, OutMaxSubsteps);
+		return;
+	}
+
+	OutStepSeconds = 1.0f / FMath::Max(FixedTimestepHz, 1.0f);
+	OutMaxSubsteps = FMath::Max(MaxFixedSubsteps, 1);
+}
+
+void UCapabilityManagerComponent::TickActiveCapabilities(float DeltaTime)
+{
+	// Tick only active capabilities - this is the main work
+	for (UBaseCapability* Capability : ActiveCapabilities)
+	{
+		float CapabilityDeltaTime = DeltaTime;
+		if (IsValid(Capability) && ShouldTickCapability(Capability, DeltaTime, CapabilityDeltaTime))
+		{
+			CAPABILITY_PROFILE_SCOPE(Capability, Tick);
+			if (Capability->CanTickOnWorkerThread())
+			{
+				// Worker-thread capabilities implement TickCapabilityConcurrent, which is just as valid on the game thread
+				Capability->TickCapabilityConcurrent(CapabilityDeltaTime);
+			}
+			else
+			{
+				FCapabilityDispatch::TickCapability(Capability, CapabilityDeltaTime);
+			}
+		}
+	}
+
+	TickLightweightCapabilities(DeltaTime);
+}
+
+void UCapabilityManagerComponent::PreTickCapabilities(float CurrentTime)
+{
+	RunPeriodicActivationUpdate(CurrentTime);
+
+	// Handle any deferred capability state updates before ticking
+	RunPendingActivationUpdates();
+
+	bIsCurrentlyTicking = true;
+}
+
+void UCapabilityManagerComponent::PostTickCapabilities()
+{
+	bIsCurrentlyTicking = false;
+
+	// Handle any capability state updates that were requested during ticking
+	RunPendingActivationUpdates();
+
+	UpdateOwnerTickDormancy();
+}
+
+bool UCapabilityManagerComponent::NeedsPeriodicActivationUpdate() const
+{
+	// Lightweight capabilities are always polled and counted in NumPolledCapabilities
+	return NumPolledCapabilities > 0 || (!Capabilities.IsEmpty() && IsActivationPollingForced());
+}
+
+void UCapabilityManagerComponent::RunPeriodicActivationUpdate(float CurrentTime)
+{
+	// Update polled capability activation states periodically (performance optimization)
+	if (CurrentTime - LastCapabilityUpdateTime >= CapabilityUpdateFrequency)
+	{
+		if (NeedsPeriodicActivationUpdate())
+		{
+			// Over budget - try again next frame, without losing our place in the period
+			if (!ConsumeActivationCheckBudget())
+			{
+				INC_DWORD_STAT(STAT_Capabilities_ActivationChecksDeferred);
+				return;
+			}
+			UpdatePolledCapabilityStates();
+		}
+		LastCapabilityUpdateTime = CurrentTime;
+	}
+}
+
+bool UCapabilityManagerComponent::IsActivationPollingForced()
+{
+	return CVarCapabilitiesForcePolling.GetValueOnGameThread();
+}
+
+bool UCapabilityManagerComponent::ConsumeActivationCheckBudget()
+{
+	if (ActivationCheckBudgetFrame != GFrameCounter)
+	{
+		ActivationCheckBudgetFrame = GFrameCounter;
+		ActivationChecksThisFrame = 0;
+	}
+
+	const int32 Budget = CVarCapabilitiesActivationChecksPerFrame.GetValueOnGameThread();
+	if (Budget > 0 && ActivationChecksThisFrame >= Budget)
+	{
+		return false;
+	}
+
+	++ActivationChecksThisFrame;
+	return true;
+}
+
+void UCapabilityManagerComponent::RunPendingActivationUpdates()
+{
+	FlushCommands();
+
+	if (bCapabilityStateUpdateRequested)
+	{
+		// A full update also covers every dirty capability
+		bCapabilityStateUpdateRequested = false;
+		UpdateCapabilityStates();
+	}
+	else if (bHasDirtyCapabilities)
+	{
+		UpdateDirtyCapabilityStates();
+	}
+}
+
+bool UCapabilityManagerComponent::ShouldTickCapability(UBaseCapability* Capability, float DeltaTime, float& OutDeltaTime)
+{
+	OutDeltaTime = DeltaTime;
+	if (!Capability->UsesTickLOD() || !CVarCapabilitiesTickLOD.GetValueOnGameThread())
+	{
+		return true;
+	}
+
+	if (Capability->AdvanceTickLOD(DeltaTime, GetSignificanceDistance(), OutDeltaTime))
+	{
+		return true;
+	}
+
+	INC_DWORD_STAT(STAT_Capabilities_LODSkippedTicks);
+	return false;
+}
+
+float UCapabilityManagerComponent::GetSignificanceDistance()
+{
+	const UWorld* World = GetWorld();
+	const AActor* Owner = GetOwner();
+	if (!World || !Owner)
+	{
+		return SignificanceDistance;
+	}
+
+	const float CurrentTime = World->GetTimeSeconds();
+	if (CurrentTime < NextSignificanceUpdateTime)
+	{
+		return SignificanceDistance;
+	}
+
+	// The first period is shortened by the manager's phase, so managers spawned together refresh in different frames
+	const float UpdateInterval = FMath::Max(CVarCapabilitiesLODDistanceUpdateInterval.GetValueOnGameThread(), 0.0f);
+	const bool bFirstUpdate = NextSignificanceUpdateTime <= 0.0f;
+	NextSignificanceUpdateTime = CurrentTime + UpdateInterval * (bFirstUpdate ? ActivationPhase : 1.0f);
+
+	// Servers have a viewpoint for every connected player, clients only for their local ones
+	const FVector OwnerLocation = Owner->GetActorLocation();
+	float ClosestDistanceSquared = TNumericLimits<float>::Max();
+	for (FConstPlayerControllerIterator Iterator = World->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		if (const APlayerController* PlayerController = Iterator->Get())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, static_cast<float>(FVector::DistSquared(OwnerLocation, ViewLocation)));
+		}
+	}
+
+	SignificanceDistance = ClosestDistanceSquared < TNumericLimits<float>::Max() ? FMath::Sqrt(ClosestDistanceSquared) : TNumericLimits<float>::Max();
+	return SignificanceDistance;
+}
+
+bool UCapabilityManagerComponent::IsTickingCapabilities() const
+{
+	return bIsCurrentlyTicking || (bTickedByScheduler && Scheduler && Scheduler->IsTickingCapabilities());
+}
+
+void UCapabilityManagerComponent::SetTickedByScheduler(bool bNewTickedByScheduler)
+{
+	bTickedByScheduler = bNewTickedByScheduler;
+
+	// The scheduler decides about the owner's tick from here on, a dormant tick counts as released
+	if (bTickedByScheduler && bOwnerTickDormant)
+	{
+		bOwnerTickDormant = false;
+		bReleasedOwnerTick = true;
+	}
+
+	// Anything requested while the owner was ticking us is now the scheduler's job
+	if (bTickedByScheduler && Scheduler && (bCapabilityStateUpdateRequested || bHasDirtyCapabilities || bHasPendingCommands))
+	{
+		Scheduler->QueueActivationUpdate(this);
+	}
+
+	AActor* Owner = GetOwner();
+	if (!Owner || !bReleaseOwnerTickWhenScheduled)
+	{
+		return;
+	}
+
+	if (bTickedByScheduler)
+	{
+		// The owner only ticked to drive this manager, so its tick function can go
+		if (!bReleasedOwnerTick && Owner->IsActorTickEnabled() && !DoesOwnerNeedTick(Owner))
+		{
+			Owner->SetActorTickEnabled(false);
+			bReleasedOwnerTick = true;
+		}
+	}
+	else if (bReleasedOwnerTick)
+	{
+		Owner->SetActorTickEnabled(true);
+		bReleasedOwnerTick = false;
+		UpdateOwnerTickDormancy();
+	}
+}
+
+void UCapabilityManagerComponent::UpdateOwnerTickDormancy()
+{
+	// Scheduled managers don't use the owner's tick, and already cost nothing while idle
+	if (bOwnerTickDormant || bTickedByScheduler || !bAllowOwnerTickDormancy)
+	{
+		return;
+	}
+
+	// Polled capabilities need the periodic activation check, so only event-driven (or no) capabilities can sleep
+	if (!ActiveCapabilities.IsEmpty() || !ActiveLightweightCapabilities.IsEmpty() || bCapabilityStateUpdateRequested || bHasDirtyCapabilities || bHasPendingCommands || NeedsPeriodicActivationUpdate())
+	{
+		return;
+	}
+
+	AActor* Owner = GetOwner();
+	if (Owner && Owner->IsActorTickEnabled() && !DoesOwnerNeedTick(Owner))
+	{
+		Owner->SetActorTickEnabled(false);
+		bOwnerTickDormant = true;
+	}
+}
+
+void UCapabilityManagerComponent::WakeOwnerTick()
+{
+	if (!bOwnerTickDormant)
+	{
+		return;
+	}
+
+	bOwnerTickDormant = false;
+	if (AActor* Owner = GetOwner())
+	{
+		Owner->SetActorTickEnabled(true);
+	}
+}
+
+bool UCapabilityManagerComponent::DoesOwnerNeedTick(const AActor* Owner)
+{
+	// Blueprint and script subclasses implementing Event Tick override ReceiveTick
+	static const FName ReceiveTickName = GET_FUNCTION_NAME_CHECKED(AActor, ReceiveTick);
+	const UFunction* TickEvent = Owner->GetClass()->FindFunctionByName(ReceiveTickName);
+	return TickEvent && TickEvent->GetOuter() != AActor::StaticClass();
+}
+
+UBaseCapability* UCapabilityManagerComponent::AddCapability(TSubclassOf<UBaseCapability> CapabilityClass)
+{
+	if (!CapabilityClass)
+	{
+		return nullptr;
+	}
+
+	// Objects can't be created off the game thread, the capability is created at the sync point instead
+	if (!IsInGameThread())
+	{
+		EnqueueCommand(ECapabilityCommandType::AddClass, nullptr, CapabilityClass);
+		return nullptr;
+	}
+
+	// Reuse a pooled instance if the class is pooled, otherwise create a new capability component
+	UCapabilityPoolSubsystem* Pool = UCapabilityPoolSubsystem::Get(this);
+	UBaseCapability* NewCapability = Pool ? Pool->Acquire(CapabilityClass, GetOwner()) : nullptr;
+	if (!NewCapability)
+	{
+		NewCapability = NewObject<UBaseCapability>(GetOwner(), CapabilityClass);
+	}
+	if (NewCapability)
+	{
+		AddCapabilityInstance(NewCapability);
+	}
+
+	return NewCapability;
+}
+
+void UCapabilityManagerComponent::AddCapabilityInstance(UBaseCapability* Capability)
+{
+	if (!IsValid(Capability) || Capabilities.Contains(Capability))
+	{
+		return;
+	}
+
+	if (ShouldDeferStructuralChanges())
+	{
+		EnqueueCommand(ECapabilityCommandType::AddInstance, Capability);
+		return;
+	}
+
+	// Ensure the capability is owned by this actor
+	if (Capability->GetOwner() != GetOwner())
+	{
+		Capability->Rename(nullptr, GetOwner());
+	}
+
+	Capability->OwningManager = this;
+
+	if (bCountedByProfiler)
+	{
+		FCapabilityProfiler::NotifyAdded(Capability);
+	}
+	CAPABILITY_PROFILE_SCOPE(Capability, Add);
+
+	// Register the capability if not already registered
+	if (!Capability->IsRegistered())
+	{
+		Capability->RegisterComponent();
+	}
+
+	Capabilities.Add(Capability);
+	AddToTypeIndex(Capability);
+	NumPolledCapabilities += Capability->GetActivationMode() == ECapabilityActivationMode::Polling ? 1 : 0;
+	
+	// Sort capabilities by priority (higher priority first)
+	Capabilities.Sort([](const UBaseCapability& A, const UBaseCapability& B) {
+		return A.GetPriority() > B.GetPriority();
+	});
+
+	// Check if it should be activated immediately
+	UpdateCapabilityActivation(Capability);
+
+	// A polled capability needs the periodic activation check, wake up the owner if it was dormant
+	if (NeedsPeriodicActivationUpdate())
+	{
+		WakeOwnerTick();
+
+		if (bTickedByScheduler && Scheduler)
+		{
+			Scheduler->ScheduleActivationCheck(this);
+		}
+	}
+}
+
+void UCapabilityManagerComponent::RemoveCapability(UBaseCapability* Capability)
+{
+	if (!IsValid(Capability))
+	{
+		return;
+	}
+
+	if (ShouldDeferStructuralChanges())
+	{
+		EnqueueCommand(ECapabilityCommandType::Remove, Capability);
+		return;
+	}
+
+	// Deactivate if currently active (or asleep)
+	if (ActiveCapabilities.Contains(Capability) || Capability->IsSleeping())
+	{
+		DeactivateCapability(Capability);
+	}
+
+	if (Capabilities.Remove(Capability) > 0)
+	{
+		if (bCountedByProfiler)
+		{
+			FCapabilityProfiler::NotifyRemoved(Capability);
+		}
+		RemoveFromTypeIndex(Capability);
+		NumPolledCapabilities -= Capability->GetActivationMode() == ECapabilityActivationMode::Polling ? 1 : 0;
+	}
+	Capability->OwningManager = nullptr;
+
+	UCapabilityPoolSubsystem* Pool = UCapabilityPoolSubsystem::Get(this);
+	if (!Pool || !Pool->Release(Capability))
+	{
+		Capability->DestroyComponent();
+	}
+
+	UpdateOwnerTickDormancy();
+}
+
+void UCapabilityManagerComponent::RemoveActorComponent(UActorComponent* Component)
+{
+	if (!IsValid(Component))
+	{
+		return;
+	}
+
+	if (UBaseCapability* Capability = Cast<UBaseCapability>(Component))
+	{
+		RemoveCapability(Capability);
+	}
+	else if (ShouldDeferStructuralChanges())
+	{
+		EnqueueCommand(ECapabilityCommandType::RemoveComponent, Component);
+	}
+	else
+	{
+		Component->DestroyComponent();
+	}
+}
+
+void UCapabilityManagerComponent::SleepCapabilityFor(UBaseCapability* Capability, float Seconds)
+{
+	const UWorld* World = GetWorld();
+	SleepCapability(Capability, (World ? World->GetTimeSeconds() : 0.0f) + FMath::Max(Seconds, 0.0f), NAME_None);
+}
+
+void UCapabilityManagerComponent::SleepCapabilityUntil(UBaseCapability* Capability, float WorldTime)
+{
+	SleepCapability(Capability, FMath::Max(WorldTime, 0.0f), NAME_None);
+}
+
+void UCapabilityManagerComponent::SleepCapabilityUntilEvent(UBaseCapability* Capability, FName Event, float TimeoutSeconds)
+{
+	const UWorld* World = GetWorld();
+	const float WakeTime = TimeoutSeconds >= 0.0f ? (World ? World->GetTimeSeconds() : 0.0f) + TimeoutSeconds : -1.0f;
+	SleepCapability(Capability, WakeTime, Event);
+}
+
+void UCapabilityManagerComponent::SleepCapabilityUntilComponentChanged(UBaseCapability* Capability, TSubclassOf<UBaseComponent> ComponentClass, float TimeoutSeconds)
+{
+	const UWorld* World = GetWorld();
+	const float WakeTime = TimeoutSeconds >= 0.0f ? (World ? World->GetTimeSeconds() : 0.0f) + TimeoutSeconds : -1.0f;
+	SleepCapability(Capability, WakeTime, NAME_None, ComponentClass);
+}
+
+void UCapabilityManagerComponent::SleepCapability(UBaseCapability* Capability, float WakeTime, FName WakeEvent, UClass* WakeComponentClass)
+{
+	if (!IsValid(Capability) || Capability->OwningManager != this || !Capability->IsActive())
+	{
+		return;
+	}
+
+	if (ShouldDeferStructuralChanges())
+	{
+		FCapabilityCommand Command;
+		Command.Type = ECapabilityCommandType::Sleep;
+		Command.Target = Capability;
+		Command.WakeTime = WakeTime;
+		Command.WakeEvent = WakeEvent;
+		Command.CapabilityClass = WakeComponentClass;
+		EnqueueCommand(MoveTemp(Command));
+		return;
+	}
+
+	// Sleeping again replaces the previous wake condition, its timer no longer matches the serial
+	++Capability->SleepSerial;
+	Capability->SleepWakeEvent = WakeEvent;
+	Capability->SleepWakeComponentClass = WakeComponentClass;
+
+	if (!Capability->bSleeping)
+	{
+		Capability->bSleeping = true;
+		ActiveCapabilities.Remove(Capability);
+		SleepingCapabilities.Add(Capability);
+
+		if (Scheduler)
+		{
+			Scheduler->RemoveFromTickBucket(Capability);
+		}
+	}
+
+	if (WakeTime >= 0.0f)
+	{
+		if (UCapabilityTimerWheelSubsystem* TimerWheel = UCapabilityTimerWheelSubsystem::Get(this))
+		{
+			TimerWheel->ScheduleWake(Capability, WakeTime);
+		}
+	}
+
+	UpdateOwnerTickDormancy();
+}
+
+void UCapabilityManagerComponent::WakeCapability(UBaseCapability* Capability)
+{
+	if (!IsValid(Capability) || Capability->OwningManager != this || !Capability->IsSleeping())
+	{
+		return;
+	}
+
+	if (ShouldDeferStructuralChanges())
+	{
+		EnqueueCommand(ECapabilityCommandType::Wake, Capability);
+		return;
+	}
+
+	ClearSleep(Capability);
+
+	if (Capability->IsActive())
+	{
+		ActiveCapabilities.Add(Capability);
+		WakeOwnerTick();
+
+		if (Scheduler)
+		{
+			Scheduler->AddToTickBucket(Capability);
+		}
+	}
+}
+
+void UCapabilityManagerComponent::SignalCapabilityEvent(FName Event)
+{
+	if (Event.IsNone())
+	{
+		return;
+	}
+
+	// Backwards, waking swap-removes from SleepingCapabilities
+	for (int32 Index = SleepingCapabilities.Num() - 1; Index >= 0; --Index)
+	{
+		UBaseCapability* Capability = SleepingCapabilities[Index];
+		if (IsValid(Capability) && Capability->SleepWakeEvent == Event)
+		{
+			WakeCapability(Capability);
+		}
+	}
+}
+
+void UCapabilityManagerComponent::ClearSleep(UBaseCapability* Capability)
+{
+	++Capability->SleepSerial;
+	Capability->bSleeping = false;
+	Capability->SleepWakeEvent = NAME_None;
+	Capability->SleepWakeComponentClass = nullptr;
+	SleepingCapabilities.RemoveSwap(Capability, EAllowShrinking::No);
+}
+
+ULightweightCapability* UCapabilityManagerComponent::AddLightweightCapability(TSubclassOf<ULightweightCapability> CapabilityClass)
+{
+	if (!CapabilityClass)
+	{
+		return nullptr;
+	}
+
+	if (!IsInGameThread())
+	{
+		EnqueueCommand(ECapabilityCommandType::AddLightweightClass, nullptr, CapabilityClass);
+		return nullptr;
+	}
+
+	// Outered to the manager rather than the actor, so it never shows up among the owner's components
+	ULightweightCapability* NewCapability = NewObject<ULightweightCapability>(this, CapabilityClass);
+	if (ShouldDeferStructuralChanges())
+	{
+		EnqueueCommand(ECapabilityCommandType::AddLightweightInstance, NewCapability);
+	}
+	else
+	{
+		AddLightweightInstance(NewCapability);
+	}
+
+	return NewCapability;
+}
+
+void UCapabilityManagerComponent::AddLightweightInstance(ULightweightCapability* Capability)
+{
+	if (!IsValid(Capability) || Capability->OwningManager)
+	{
+		return;
+	}
+
+	Capability->OwningManager = this;
+
+	// Insert after every capability of the same or higher priority, so the array stays sorted
+	const int32 InsertIndex = Algo::UpperBoundBy(LightweightCapabilities, Capability->GetPriority(),
+		[](const ULightweightCapability* Other) { return Other->GetPriority(); }, TGreater<int32>());
+	LightweightCapabilities.Insert(Capability, InsertIndex);
+	++NumPolledCapabilities;
+
+	UpdateLightweightActivation(Capability);
+
+	WakeOwnerTick();
+
+	if (bTickedByScheduler && Scheduler)
+	{
+		Scheduler->ScheduleActivationCheck(this);
+	}
+}
+
+void UCapabilityManagerComponent::RemoveLightweightCapability(ULightweightCapability* Capability)
+{
+	if (!IsValid(Capability) || Capability->OwningManager != this)
+	{
+		return;
+	}
+
+	if (ShouldDeferStructuralChanges())
+	{
+		EnqueueCommand(ECapabilityCommandType::RemoveLightweight, Capability);
+		return;
+	}
+
+	if (Capability->IsActive())
+	{
+		DeactivateLightweightCapability(Capability);
+	}
+
+	LightweightCapabilities.Remove(Capability);
+	--NumPolledCapabilities;
+
+	// Nothing else references it, it's collected with the next GC
+	Capability->OwningManager = nullptr;
+
+	UpdateOwnerTickDormancy();
+}
+
+void UCapabilityManagerComponent::TickLightweightCapabilities(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_Capabilities_LightweightTick);
+
+	// Activation changes are deferred while ticking, so the array can't change under us
+	for (ULightweightCapability* Capability : ActiveLightweightCapabilities)
+	{
+		if (IsValid(Capability))
+		{
+			Capability->TickCapability(DeltaTime);
+		}
+	}
+}
+
+void UCapabilityManagerComponent::UpdateLightweightActivation(ULightweightCapability* Capability)
+{
+	if (!IsValid(Capability))
+	{
+		return;
+	}
+
+	const bool bShouldBeActive = Capability->ShouldBeActive();
+	if (Capability->IsActive())
+	{
+		if (!bShouldBeActive || Capability->ShouldDeactivate())
+		{
+			DeactivateLightweightCapability(Capability);
+		}
+	}
+	else if (bShouldBeActive && Capability->ShouldActivate())
+	{
+		ActivateLightweightCapability(Capability);
+	}
+}
+
+void UCapabilityManagerComponent::ActivateLightweightCapability(ULightweightCapability* Capability)
 {
-	Super::BeginPlay();
-	
-	// Initialize any capabilities that should start active
-	UpdateCapabilityStates();
-	
-	// Always disable auto-ticking since we use manual ticking
-	SetComponentTickEnabled(false);
-}
+	Capability->bIsActive = true;
 
-void UCapabilityManagerComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
-{
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-	
-	ManualTick(DeltaTime);
-}
+	// Same priority order as LightweightCapabilities
+	const int32 InsertIndex = Algo::UpperBoundBy(ActiveLightweightCapabilities, Capability->GetPriority(),
+		[](const ULightweightCapability* Other) { return Other->GetPriority(); }, TGreater<int32>());
+	ActiveLightweightCapabilities.Insert(Capability, InsertIndex);
 
-void UCapabilityManagerComponent::ManualTick(float DeltaTime)
-{
-	// Only get time once per frame instead of every call
-	const float CurrentTime = GetWorld()->GetTimeSeconds();
-	
-	// Update capability activation states periodically (performance optimization)
-	if (CurrentTime - LastCapabilityUpdateTime >= CapabilityUpdateFrequency)
+	Capability->OnCapabilityActivated();
+
+	WakeOwnerTick();
+
+	if (Scheduler && ActiveLightweightCapabilities.Num() == 1)
 	{
-		UpdateCapabilityStates();
-		LastCapabilityUpdateTime = CurrentTime;
+		Scheduler->AddLightweightTickManager(this);
 	}
+}
 
-	// Handle any deferred capability state updates before ticking
-	if (bCapabilityStateUpdateRequested && !bIsCurrentlyTicking)
+void UCapabilityManagerComponent::DeactivateLightweightCapability(ULightweightCapability* Capability)
+{
+	Capability->bIsActive = false;
+	ActiveLightweightCapabilities.Remove(Capability);
+
+	Capability->OnCapabilityDeactivated();
+
+	if (Scheduler && ActiveLightweightCapabilities.IsEmpty())
 	{
-		UpdateCapabilityStates();
-		bCapabilityStateUpdateRequested = false;
+		Scheduler->RemoveLightweightTickManager(this);
 	}
+}
 
-	// Tick only active capabilities - this is the main work
-	bIsCurrentlyTicking = true;
-	for (UBaseCapability* Capability : ActiveCapabilities)
+UBaseCapability* UCapabilityManagerComponent::GetCapability(TSubclassOf<UBaseCapability> CapabilityClass) const
+{
+	// Usually the first entry, the loop only skips capabilities destroyed behind the manager's back
+	for (UBaseCapability* Capability : GetCapabilitiesView(CapabilityClass))
 	{
 		if (IsValid(Capability))
 		{
-			Capability->TickCapability(DeltaTime);
+			return Capability;
 		}
 	}
-	bIsCurrentlyTicking = false;
+	return nullptr;
+}
 
-	// Handle any capability state updates that were requested during ticking
-	if (bCapabilityStateUpdateRequested)
+TArray<UBaseCapability*> UCapabilityManagerComponent::GetCapabilities(TSubclassOf<UBaseCapability> CapabilityClass) const
+{
+	TArray<UBaseCapability*> FoundCapabilities;
+
+	const TArrayView<UBaseCapability* const> CapabilitiesOfClass = GetCapabilitiesView(CapabilityClass);
+	FoundCapabilities.Reserve(CapabilitiesOfClass.Num());
+	for (UBaseCapability* Capability : CapabilitiesOfClass)
 	{
-		UpdateCapabilityStates();
-		bCapabilityStateUpdateRequested = false;
+		if (IsValid(Capability))
+		{
+			FoundCapabilities.Add(Capability);
+		}
 	}
+	return FoundCapabilities;
 }
 
-UBaseCapability* UCapabilityManagerComponent::AddCapability(TSubclassOf<UBaseCapability> CapabilityClass)
+TArrayView<UBaseCapability* const> UCapabilityManagerComponent::GetCapabilitiesView(TSubclassOf<UBaseCapability> CapabilityClass) const
 {
 	if (!CapabilityClass)
 	{
-		return nullptr;
+		return TArrayView<UBaseCapability* const>();
 	}
 
-	// Create new capability component
-	UBaseCapability* NewCapability = NewObject<UBaseCapability>(GetOwner(), CapabilityClass);
-	if (NewCapability)
+	if (CapabilityClass == UBaseCapability::StaticClass())
 	{
-		AddCapabilityInstance(NewCapability);
+		return Capabilities;
 	}
 
-	return NewCapability;
+	const int32 TypeId = UBaseCapability::GetCapabilityTypeId(CapabilityClass);
+	if (!CapabilitiesByType.IsValidIndex(TypeId))
+	{
+		return TArrayView<UBaseCapability* const>();
+	}
+	return CapabilitiesByType[TypeId];
 }
 
-void UCapabilityManagerComponent::AddCapabilityInstance(UBaseCapability* Capability)
+void UCapabilityManagerComponent::AddToTypeIndex(UBaseCapability* Capability)
 {
-	if (!IsValid(Capability) || Capabilities.Contains(Capability))
+	// Index the capability under its own class and every capability superclass, so subclass lookups are a single array access
+	for (const UClass* Class = Capability->GetClass(); Class && Class != UBaseCapability::StaticClass(); Class = Class->GetSuperClass())
 	{
-		return;
+		const int32 TypeId = UBaseCapability::GetCapabilityTypeId(Class);
+		if (TypeId == INDEX_NONE)
+		{
+			continue;
+		}
+
+		if (TypeId >= CapabilitiesByType.Num())
+		{
+			CapabilitiesByType.SetNum(TypeId + 1);
+		}
+
+		// Keep the same priority order as Capabilities
+		TArray<UBaseCapability*>& CapabilitiesOfType = CapabilitiesByType[TypeId];
+		const int32 InsertIndex = Algo::UpperBoundBy(CapabilitiesOfType, Capability->GetPriority(),
+			[](const UBaseCapability* Other) { return Other->GetPriority(); }, TGreater<int32>());
+		CapabilitiesOfType.Insert(Capability, InsertIndex);
 	}
+}
 
-	// Ensure the capability is owned by this actor
-	if (Capability->GetOwner() != GetOwner())
+void UCapabilityManagerComponent::RemoveFromTypeIndex(UBaseCapability* Capability)
+{
+	for (const UClass* Class = Capability->GetClass(); Class && Class != UBaseCapability::StaticClass(); Class = Class->GetSuperClass())
 	{
-		Capability->Rename(nullptr, GetOwner());
+		const int32 TypeId = UBaseCapability::GetCapabilityTypeId(Class);
+		if (CapabilitiesByType.IsValidIndex(TypeId))
+		{
+			CapabilitiesByType[TypeId].Remove(Capability);
+		}
 	}
+}
 
-	// Register the capability if not already registered
-	if (!Capability->IsRegistered())
+void UCapabilityManagerComponent::UpdateCapabilityStates()
+{
+	// If we're currently ticking, defer this update to avoid array modification during iteration
+	if (IsTickingCapabilities())
 	{
-		Capability->RegisterComponent();
+		RequestCapabilityStateUpdate();
+		return;
 	}
 
-	Capabilities.Add(Capability);
-	
-	// Sort capabilities by priority (higher priority first)
-	Capabilities.Sort([](const UBaseCapability& A, const UBaseCapability& B) {
-		return A.GetPriority() > B.GetPriority();
-	});
+	bHasDirtyCapabilities = false;
 
-	// Check if it should be activated immediately
-	UpdateCapabilityActivation(Capability);
+	// Structural changes made by activation callbacks are recorded and applied once the loop is done
+	++StructuralChangeLockDepth;
+	for (int32 Index = 0; Index < Capabilities.Num(); ++Index)
+	{
+		UBaseCapability* Capability = Capabilities[Index];
+		if (IsValid(Capability))
+		{
+			Capability->bActivationDirty = false;
+			UpdateCapabilityActivation(Capability);
+		}
+	}
+	for (int32 Index = 0; Index < LightweightCapabilities.Num(); ++Index)
+	{
+		UpdateLightweightActivation(LightweightCapabilities[Index]);
+	}
+	--StructuralChangeLockDepth;
+	FlushCommands();
+
+	UpdateOwnerTickDormancy();
 }
 
-void UCapabilityManagerComponent::RemoveCapability(UBaseCapability* Capability)
+void UCapabilityManagerComponent::UpdatePolledCapabilityStates()
 {
-	if (!IsValid(Capability))
+	if (IsTickingCapabilities())
 	{
+		RequestCapabilityStateUpdate();
 		return;
 	}
 
-	// Deactivate if currently active
-	if (ActiveCapabilities.Contains(Capability))
+	INC_DWORD_STAT(STAT_Capabilities_ActivationChecks);
+
+	// Structural changes made by activation callbacks are recorded and applied once the loop is done
+	++StructuralChangeLockDepth;
+	for (int32 Index = 0; Index < Capabilities.Num(); ++Index)
 	{
-		DeactivateCapability(Capability);
+		UBaseCapability* Capability = Capabilities[Index];
+		if (IsValid(Capability) && IsPolled(Capability))
+		{
+			UpdateCapabilityActivation(Capability);
+		}
 	}
-
-	Capabilities.Remove(Capability);
-	Capability->DestroyComponent();
+	for (int32 Index = 0; Index < LightweightCapabilities.Num(); ++Index)
+	{
+		UpdateLightweightActivation(LightweightCapabilities[Index]);
+	}
+	--StructuralChangeLockDepth;
+	FlushCommands();
 }
 
-void UCapabilityManagerComponent::RemoveActorComponent(UActorComponent* Component)
+void UCapabilityManagerComponent::UpdateDirtyCapabilityStates()
 {
-	if (!IsValid(Component))
+	if (IsTickingCapabilities())
 	{
+		MarkActivationDirty();
 		return;
 	}
 
-	if (UBaseCapability* Capability = Cast<UBaseCapability>(Component))
+	bHasDirtyCapabilities = false;
+
+	// Structural changes made by activation callbacks are recorded and applied once the loop is done
+	++StructuralChangeLockDepth;
+	for (int32 Index = 0; Index < Capabilities.Num(); ++Index)
 	{
-		RemoveCapability(Capability);
+		UBaseCapability* Capability = Capabilities[Index];
+		if (IsValid(Capability) && Capability->bActivationDirty)
+		{
+			Capability->bActivationDirty = false;
+			UpdateCapabilityActivation(Capability);
+		}
 	}
-	else
+	--StructuralChangeLockDepth;
+	FlushCommands();
+}
+
+void UCapabilityManagerComponent::MarkActivationDirty()
+{
+	check(IsInGameThread());
+
+	bHasDirtyCapabilities = true;
+	WakeOwnerTick();
+
+	if (bTickedByScheduler && Scheduler)
 	{
-		Component->DestroyComponent();
+		Scheduler->QueueActivationUpdate(this);
 	}
 }
 
-UBaseCapability* UCapabilityManagerComponent::GetCapability(TSubclassOf<UBaseCapability> CapabilityClass) const
+bool UCapabilityManagerComponent::IsPolled(const UBaseCapability* Capability) const
 {
-	if (!CapabilityClass)
+	return Capability->GetActivationMode() == ECapabilityActivationMode::Polling || IsActivationPollingForced();
+}
+
+void UCapabilityManagerComponent::NotifyComponentChanged(UBaseComponent* Component, FName FieldName)
+{
+	if (!IsValid(Component))
 	{
-		return nullptr;
+		return;
 	}
 
+	// Worker-thread capabilities writing their components can't touch other capabilities' flags or the owner's tick
+	if (!IsInGameThread())
+	{
+		FCapabilityCommand Command;
+		Command.Type = ECapabilityCommandType::ComponentChanged;
+		Command.Target = Component;
+		Command.ChangedName = FieldName;
+		EnqueueCommand(MoveTemp(Command));
+		return;
+	}
+
+	bool bAnyDirty = false;
 	for (UBaseCapability* Capability : Capabilities)
 	{
-		if (IsValid(Capability) && Capability->IsA(CapabilityClass))
+		if (IsValid(Capability) && !Capability->bActivationDirty && Capability->DependsOnComponent(Component, FieldName))
 		{
-			return Capability;
+			Capability->bActivationDirty = true;
+			bAnyDirty = true;
 		}
 	}
-	return nullptr;
-}
 
-TArray<UBaseCapability*> UCapabilityManagerComponent::GetCapabilities(TSubclassOf<UBaseCapability> CapabilityClass) const
-{
-	TArray<UBaseCapability*> FoundCapabilities;
-	
-	if (!CapabilityClass)
+	if (bAnyDirty)
 	{
-		return FoundCapabilities;
+		MarkActivationDirty();
 	}
 
-	for (UBaseCapability* Capability : Capabilities)
+	// Backwards, waking swap-removes from SleepingCapabilities
+	for (int32 Index = SleepingCapabilities.Num() - 1; Index >= 0; --Index)
 	{
-		if (IsValid(Capability) && Capability->IsA(CapabilityClass))
+		UBaseCapability* Capability = SleepingCapabilities[Index];
+		if (IsValid(Capability) && Capability->SleepWakeComponentClass && Component->IsA(Capability->SleepWakeComponentClass))
 		{
-			FoundCapabilities.Add(Capability);
+			WakeCapability(Capability);
 		}
 	}
-	return FoundCapabilities;
 }
 
-void UCapabilityManagerComponent::UpdateCapabilityStates()
+void UCapabilityManagerComponent::NotifyOwnerTagChanged(FName Tag)
 {
-	// If we're currently ticking, defer this update to avoid array modification during iteration
-	if (bIsCurrentlyTicking)
+	if (!IsInGameThread())
 	{
-		bCapabilityStateUpdateRequested = true;
+		FCapabilityCommand Command;
+		Command.Type = ECapabilityCommandType::OwnerTagChanged;
+		Command.ChangedName = Tag;
+		EnqueueCommand(MoveTemp(Command));
 		return;
 	}
 
-	// Create a copy to avoid modification during iteration
-	TArray<UBaseCapability*> CapabilitiesToCheck = Capabilities;
-
-	for (UBaseCapability* Capability : CapabilitiesToCheck)
+	bool bAnyDirty = false;
+	for (UBaseCapability* Capability : Capabilities)
 	{
-		if (IsValid(Capability))
+		if (IsValid(Capability) && !Capability->bActivationDirty && Capability->DependsOnTag(Tag))
 		{
-			UpdateCapabilityActivation(Capability);
+			Capability->bActivationDirty = true;
+			bAnyDirty = true;
 		}
 	}
+
+	if (bAnyDirty)
+	{
+		MarkActivationDirty();
+	}
+}
+
+void UCapabilityManagerComponent::AddOwnerTag(FName Tag)
+{
+	AActor* Owner = GetOwner();
+	if (Owner && !Owner->Tags.Contains(Tag))
+	{
+		Owner->Tags.Add(Tag);
+		NotifyOwnerTagChanged(Tag);
+	}
+}
+
+void UCapabilityManagerComponent::RemoveOwnerTag(FName Tag)
+{
+	AActor* Owner = GetOwner();
+	if (Owner && Owner->Tags.Remove(Tag) > 0)
+	{
+		NotifyOwnerTagChanged(Tag);
+	}
 }
 
 void UCapabilityManagerComponent::UpdateCapabilityActivation(UBaseCapability* Capability)
@@ -212,13 +1214,32 @@ void UCapabilityManagerComponent::UpdateCapabilityActivation(UBaseCapability* Ca
 		return;
 	}
 
+	if (Capability->UsesActivationPredicate())
+	{
+		// Scheduled managers leave predicates to the scheduler, which evaluates every queued capability of a class at once
+		if (bTickedByScheduler && Scheduler)
+		{
+			Scheduler->QueuePredicateEvaluation(Capability);
+			return;
+		}
+
+		CAPABILITY_PROFILE_SCOPE(Capability, ActivationCheck);
+
+		const FCapabilityPredicateProgram* Program = FCapabilityPredicateProgram::Get(Capability);
+		Program->Evaluate(MakeArrayView(&Capability, 1), SinglePredicateResult);
+		ApplyActivationPredicate(Capability, SinglePredicateResult[0] != 0);
+		return;
+	}
+
+	CAPABILITY_PROFILE_SCOPE(Capability, ActivationCheck);
+
 	const bool bIsCurrentlyActive = Capability->IsActive();
-	const bool bShouldBeActive = Capability->ShouldBeActive();
+	const bool bShouldBeActive = FCapabilityDispatch::ShouldBeActive(Capability);
 
 	if (bIsCurrentlyActive)
 	{
 		// Check if it should deactivate
-		if (!bShouldBeActive || Capability->ShouldDeactivate())
+		if (!bShouldBeActive || FCapabilityDispatch::ShouldDeactivate(Capability))
 		{
 			DeactivateCapability(Capability);
 		}
@@ -226,13 +1247,53 @@ void UCapabilityManagerComponent::UpdateCapabilityActivation(UBaseCapability* Ca
 	else
 	{
 		// Check if it should activate
-		if (bShouldBeActive && Capability->ShouldActivate())
+		if (bShouldBeActive && FCapabilityDispatch::ShouldActivate(Capability))
 		{
 			ActivateCapability(Capability);
 		}
 	}
 }
 
+void UCapabilityManagerComponent::ApplyActivationPredicate(UBaseCapability* Capability, bool bConditionsMet)
+{
+	if (Capability->IsActive())
+	{
+		if (!bConditionsMet)
+		{
+			DeactivateCapability(Capability);
+		}
+		return;
+	}
+
+	if (!bConditionsMet)
+	{
+		return;
+	}
+
+	const float RemainingCooldown = Capability->GetRemainingCooldown(GetWorld()->GetTimeSeconds());
+	if (RemainingCooldown > 0.0f)
+	{
+		// Polled capabilities see the cooldown end at a later check, event-driven ones need a reminder
+		FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+		if (!IsPolled(Capability) && !TimerManager.IsTimerActive(Capability->CooldownTimerHandle))
+		{
+			TWeakObjectPtr<UBaseCapability> WeakCapability = Capability;
+			TimerManager.SetTimer(Capability->CooldownTimerHandle, FTimerDelegate::CreateWeakLambda(this, [this, WeakCapability]()
+			{
+				UBaseCapability* CooledCapability = WeakCapability.Get();
+				if (CooledCapability && CooledCapability->OwningManager == this)
+				{
+					CooledCapability->bActivationDirty = true;
+					MarkActivationDirty();
+				}
+			}), RemainingCooldown, false);
+		}
+		return;
+	}
+
+	ActivateCapability(Capability);
+}
+
 void UCapabilityManagerComponent::ActivateCapability(UBaseCapability* Capability)
 {
 	if (!IsValid(Capability) || Capability->IsActive())
@@ -240,6 +1301,8 @@ void UCapabilityManagerComponent::ActivateCapability(UBaseCapability* Capability
 		return;
 	}
 
+	CAPABILITY_PROFILE_SCOPE(Capability, Activate);
+
 	// Use built-in activation system
 	Capability->SetActive(true);
 	
@@ -247,6 +1310,17 @@ void UCapabilityManagerComponent::ActivateCapability(UBaseCapability* Capability
 	if (!ActiveCapabilities.Contains(Capability))
 	{
 		ActiveCapabilities.Add(Capability);
+		if (bCountedByProfiler)
+		{
+			FCapabilityProfiler::NotifyActivated(Capability);
+		}
+	}
+
+	WakeOwnerTick();
+
+	if (Scheduler)
+	{
+		Scheduler->AddToTickBucket(Capability);
 	}
 }
 
@@ -257,15 +1331,144 @@ void UCapabilityManagerComponent::DeactivateCapability(UBaseCapability* Capabili
 		return;
 	}
 
+	CAPABILITY_PROFILE_SCOPE(Capability, Deactivate);
+
+	// A deactivated capability has nothing to wake up for. Sleeping ones already left ActiveCapabilities but still count as active.
+	const bool bWasSleeping = Capability->IsSleeping();
+	if (bWasSleeping)
+	{
+		ClearSleep(Capability);
+	}
+
 	// Use built-in deactivation system
 	Capability->SetActive(false);
+	Capability->LastDeactivationTime = GetWorld()->GetTimeSeconds();
 	
 	// Remove from active list
-	ActiveCapabilities.Remove(Capability);
+	if ((ActiveCapabilities.Remove(Capability) > 0 || bWasSleeping) && bCountedByProfiler)
+	{
+		FCapabilityProfiler::NotifyDeactivated(Capability);
+	}
+
+	if (Scheduler)
+	{
+		Scheduler->RemoveFromTickBucket(Capability);
+	}
 }
 
 void UCapabilityManagerComponent::RequestCapabilityStateUpdate()
 {
+	// Worker-thread capabilities record the request, it's applied on the game thread at the next sync point
+	if (!IsInGameThread())
+	{
+		EnqueueCommand(ECapabilityCommandType::RequestStateUpdate, nullptr);
+		return;
+	}
+
 	// This is the safe version that capabilities should call during their TickCapability
 	bCapabilityStateUpdateRequested = true;
+	WakeOwnerTick();
+
+	if (bTickedByScheduler && Scheduler)
+	{
+		Scheduler->QueueActivationUpdate(this);
+	}
+}
+
+bool UCapabilityManagerComponent::ShouldDeferStructuralChanges() const
+{
+	return !IsInGameThread() || IsTickingCapabilities() || StructuralChangeLockDepth > 0;
+}
+
+void UCapabilityManagerComponent::EnqueueCommand(ECapabilityCommandType Type, UObject* Target, UClass* CapabilityClass)
+{
+	FCapabilityCommand Command;
+	Command.Type = Type;
+	Command.Target = Target;
+	Command.CapabilityClass = CapabilityClass;
+	EnqueueCommand(MoveTemp(Command));
+}
+
+void UCapabilityManagerComponent::EnqueueCommand(FCapabilityCommand&& Command)
+{
+	{
+		FScopeLock Lock(&CommandLock);
+		PendingCommands.Add(MoveTemp(Command));
+		bHasPendingCommands = true;
+	}
+
+	if (!IsInGameThread())
+	{
+		// The scheduler brings the manager back to the game thread at the sync point after the current wave
+		if (Scheduler)
+		{
+			Scheduler->EnqueueWorkerStateUpdateRequest(this);
+		}
+		return;
+	}
+
+	WakeOwnerTick();
+
+	if (bTickedByScheduler && Scheduler)
+	{
+		Scheduler->QueueActivationUpdate(this);
+	}
+}
+
+void UCapabilityManagerComponent::FlushCommands()
+{
+	check(IsInGameThread());
+
+	// Applying a command can record new ones (capabilities adding others on activation), keep going until the buffer is empty
+	while (bHasPendingCommands && !ShouldDeferStructuralChanges())
+	{
+		TArray<FCapabilityCommand> Commands;
+		{
+			FScopeLock Lock(&CommandLock);
+			Commands = MoveTemp(PendingCommands);
+			PendingCommands.Reset();
+			bHasPendingCommands = false;
+		}
+
+		for (const FCapabilityCommand& Command : Commands)
+		{
+			switch (Command.Type)
+			{
+			case ECapabilityCommandType::AddInstance:
+				AddCapabilityInstance(Cast<UBaseCapability>(Command.Target));
+				break;
+			case ECapabilityCommandType::AddClass:
+				AddCapability(Command.CapabilityClass);
+				break;
+			case ECapabilityCommandType::Remove:
+			case ECapabilityCommandType::RemoveComponent:
+				RemoveActorComponent(Cast<UActorComponent>(Command.Target));
+				break;
+			case ECapabilityCommandType::RequestStateUpdate:
+				bCapabilityStateUpdateRequested = true;
+				break;
+			case ECapabilityCommandType::AddLightweightInstance:
+				AddLightweightInstance(Cast<ULightweightCapability>(Command.Target));
+				break;
+			case ECapabilityCommandType::AddLightweightClass:
+				AddLightweightCapability(Command.CapabilityClass);
+				break;
+			case ECapabilityCommandType::RemoveLightweight:
+				RemoveLightweightCapability(Cast<ULightweightCapability>(Command.Target));
+				break;
+			case ECapabilityCommandType::Sleep:
+				SleepCapability(Cast<UBaseCapability>(Command.Target), Command.WakeTime, Command.WakeEvent, Command.CapabilityClass);
+				break;
+			case ECapabilityCommandType::Wake:
+				WakeCapability(Cast<UBaseCapability>(Command.Target));
+				break;
+			case ECapabilityCommandType::ComponentChanged:
+				NotifyComponentChanged(Cast<UBaseComponent>(Command.Target), Command.ChangedName);
+				break;
+			case ECapabilityCommandType::OwnerTagChanged:
+				NotifyOwnerTagChanged(Command.ChangedName);
+				break;
+			}
+		}
+	}
 }
\ No newline at end of file
@@ -4,16 +4,68 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "../Capabilities/CapabilityFixedTimestep.h"
+#include "HAL/CriticalSection.h"
+#include <atomic>
 
 // Forward declaration instead of full include in header
 class UBaseCapability;
+class UBaseComponent;
+class UCapabilitySchedulerSubsystem;
+class ULightweightCapability;
 
 #include "CapabilityManagerComponent.generated.h"
 
+// Structural change recorded while it couldn't be applied right away
+enum class ECapabilityCommandType : uint8
+{
+	AddInstance,
+	AddClass,
+	Remove,
+	RemoveComponent,
+	RequestStateUpdate,
+	AddLightweightInstance,
+	AddLightweightClass,
+	RemoveLightweight,
+	Sleep,
+	Wake,
+	ComponentChanged,
+	OwnerTagChanged
+};
+
+/**
+ * Entry of the manager's command buffer. Targets are UPROPERTYs so pending capabilities survive until they're applied.
+ */
+USTRUCT()
+struct FCapabilityCommand
+{
+	GENERATED_BODY()
+
+	ECapabilityCommandType Type = ECapabilityCommandType::RequestStateUpdate;
+
+	UPROPERTY()
+	UObject* Target = nullptr;
+
+	// Class to add, or the component class a Sleep waits for
+	UPROPERTY()
+	UClass* CapabilityClass = nullptr;
+
+	// Sleep parameters, a negative WakeTime only wakes on WakeEvent or a component change
+	float WakeTime = -1.0f;
+	FName WakeEvent;
+
+	// Field or owner tag of a change reported from a worker thread
+	FName ChangedName;
+};
+
 /**
  * Capability Manager Component that handles all ECS capability logic.
  * This component can be added to any Actor to provide capability management functionality.
  * This eliminates code duplication across Actor, Pawn, Character, and PlayerController classes.
+ *
+ * Structural changes (adding and removing capabilities or components, state update requests) made while capabilities
+ * are ticking, while the manager iterates its capabilities, or from worker threads are recorded in a command buffer
+ * and applied together at the next sync point: after the owner's ManualTick, or when the scheduler processes the manager.
  */
 UCLASS(BlueprintType, Blueprintable, meta = (BlueprintSpawnableComponent))
 class CREATIVEGAME_API UCapabilityManagerComponent : public UActorComponent
@@ -24,9 +76,11 @@ public:
 	UCapabilityManagerComponent();
 
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
-	// Capability management
+	// Capability management - recorded and applied at the next sync point while capabilities tick.
+	// Returns null when called from a worker thread, the capability is created on the game thread later.
 	UFUNCTION(BlueprintCallable, Category = "Capabilities")
 	UBaseCapability* AddCapability(TSubclassOf<UBaseCapability> CapabilityClass);
 
@@ -42,12 +96,58 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Capabilities")
 	TArray<UBaseCapability*> GetCapabilities(TSubclassOf<UBaseCapability> CapabilityClass) const;
 
+	// Allocation-free GetCapabilities, in priority order. Only valid until capabilities are next added or removed.
+	TArrayView<UBaseCapability* const> GetCapabilitiesView(TSubclassOf<UBaseCapability> CapabilityClass) const;
+
+	template<typename T>
+	T* GetCapability() const
+	{
+		return static_cast<T*>(GetCapability(T::StaticClass()));
+	}
+
 	UFUNCTION(BlueprintCallable, Category = "Capabilities")
 	TArray<UBaseCapability*> GetAllCapabilities() const { return Capabilities; }
 
 	UFUNCTION(BlueprintCallable, Category = "Capabilities")
 	TArray<UBaseCapability*> GetActiveCapabilities() const { return ActiveCapabilities; }
 
+	// Sleep - an active capability stops ticking, without being deactivated, until it's woken by time or by an event.
+	// Sleeping capabilities cost nothing per frame, timed wakes come from UCapabilityTimerWheelSubsystem.
+	UFUNCTION(BlueprintCallable, Category = "Capabilities")
+	void SleepCapabilityFor(UBaseCapability* Capability, float Seconds);
+
+	UFUNCTION(BlueprintCallable, Category = "Capabilities")
+	void SleepCapabilityUntil(UBaseCapability* Capability, float WorldTime);
+
+	// Sleep until SignalCapabilityEvent(Event), or until TimeoutSeconds pass when positive
+	UFUNCTION(BlueprintCallable, Category = "Capabilities")
+	void SleepCapabilityUntilEvent(UBaseCapability* Capability, FName Event, float TimeoutSeconds = -1.0f);
+
+	// Sleep until a component of ComponentClass on the owner reports a change, or until TimeoutSeconds pass when positive
+	UFUNCTION(BlueprintCallable, Category = "Capabilities")
+	void SleepCapabilityUntilComponentChanged(UBaseCapability* Capability, TSubclassOf<UBaseComponent> ComponentClass, float TimeoutSeconds = -1.0f);
+
+	UFUNCTION(BlueprintCallable, Category = "Capabilities")
+	void WakeCapability(UBaseCapability* Capability);
+
+	// Wake every capability of this manager sleeping until Event
+	UFUNCTION(BlueprintCallable, Category = "Capabilities")
+	void SignalCapabilityEvent(FName Event);
+
+	// Lightweight capabilities - plain objects owned by this manager, see ULightweightCapability.
+	// Returns null when called from a worker thread, the capability is created on the game thread later.
+	UFUNCTION(BlueprintCallable, Category = "Capabilities")
+	ULightweightCapability* AddLightweightCapability(TSubclassOf<ULightweightCapability> CapabilityClass);
+
+	UFUNCTION(BlueprintCallable, Category = "Capabilities")
+	void RemoveLightweightCapability(ULightweightCapability* Capability);
+
+	UFUNCTION(BlueprintCallable, Category = "Capabilities")
+	TArray<ULightweightCapability*> GetLightweightCapabilities() const { return LightweightCapabilities; }
+
+	// Tick every active lightweight capability - called by ManualTick and by the scheduler
+	void TickLightweightCapabilities(float DeltaTime);
+
 	// Component management
 	UFUNCTION(BlueprintCallable, Category = "Components")
 	void RemoveActorComponent(UActorComponent* Component);
@@ -60,15 +160,122 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Capabilities")
 	void RequestCapabilityStateUpdate();
 
+	// Event-driven activation - re-check capabilities that declared a dependency on this component (or field).
+	// Changes reported from worker threads are recorded and applied on the game thread at the next sync point.
+	UFUNCTION(BlueprintCallable, Category = "Capabilities")
+	void NotifyComponentChanged(UBaseComponent* Component, FName FieldName = NAME_None);
+
+	// Event-driven activation - re-check capabilities that declared a dependency on this owner tag
+	UFUNCTION(BlueprintCallable, Category = "Capabilities")
+	void NotifyOwnerTagChanged(FName Tag);
+
+	// Add/remove an owner actor tag and notify dependent capabilities
+	UFUNCTION(BlueprintCallable, Category = "Capabilities")
+	void AddOwnerTag(FName Tag);
+
+	UFUNCTION(BlueprintCallable, Category = "Capabilities")
+	void RemoveOwnerTag(FName Tag);
+
 	// Manual tick for when owner doesn't want auto-ticking
 	UFUNCTION(BlueprintCallable, Category = "Capabilities")
 	void ManualTick(float DeltaTime);
 
+	// Whether the world capability scheduler ticks this manager (owners should skip ManualTick when true)
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	bool IsTickedByScheduler() const { return bTickedByScheduler; }
+
+	// Opt out of scheduler batch ticking, only takes effect when set before BeginPlay (e.g. on a deferred spawn)
+	void SetUseCapabilityScheduler(bool bUse) { bUseCapabilityScheduler = bUse; }
+
+	// Keep the owner's actor tick running even when the scheduler ticks this manager (e.g. PlayerControllers need PlayerTick)
+	void SetReleaseOwnerTickWhenScheduled(bool bRelease) { bReleaseOwnerTickWhenScheduled = bRelease; }
+
+	// Keep the owner's actor tick running even when nothing needs ticking
+	void SetAllowOwnerTickDormancy(bool bAllow) { bAllowOwnerTickDormancy = bAllow; }
+
+	// Whether the owner's tick is currently disabled because no capability needs it
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	bool IsOwnerTickDormant() const { return bOwnerTickDormant; }
+
+	// Fixed timestep - true when this manager (or ECS.FixedStep.Enabled) runs capabilities at a fixed rate
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	bool IsFixedTimestep() const;
+
+	// Fraction of a fixed step left unsimulated this frame, for interpolating rendered state. 1 without a fixed timestep.
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	float GetInterpolationAlpha() const;
+
+	// Whether structural changes are recorded in the command buffer instead of being applied immediately
+	bool ShouldDeferStructuralChanges() const;
+
+	// Sync point - apply every recorded structural change in order
+	void FlushCommands();
+
+	// Split phases of ManualTick
+	void PreTickCapabilities(float CurrentTime);
+	void PostTickCapabilities();
+
+	// Activation passes run by ManualTick and by UCapabilitySchedulerSubsystem
+	bool NeedsPeriodicActivationUpdate() const;
+	void RunPeriodicActivationUpdate(float CurrentTime);
+	void RunPendingActivationUpdates();
+
+	// True while capabilities of this manager are being ticked, structural changes must be deferred
+	bool IsTickingCapabilities() const;
+
+	// Tick LOD - whether an active capability ticks this frame, and with which (accumulated) DeltaTime
+	bool ShouldTickCapability(UBaseCapability* Capability, float DeltaTime, float& OutDeltaTime);
+
+	// Distance from the owner to the closest player viewpoint, refreshed every ECS.LOD.DistanceUpdateInterval seconds
+	UFUNCTION(BlueprintCallable, Category = "Capabilities")
+	float GetSignificanceDistance();
+
+	// Called by the scheduler when it takes over ticking or hands it back to the owner
+	void SetTickedByScheduler(bool bNewTickedByScheduler);
+
 private:
+	friend class UCapabilitySchedulerSubsystem;
+
+	// Whether the owner defines its own tick logic (Blueprint or script Event Tick) and must keep ticking
+	static bool DoesOwnerNeedTick(const AActor* Owner);
+
+	// Periodic activation check pacing, shared by owner-ticked and scheduled managers
+	static bool IsActivationPollingForced();
+
+	// ECS.FixedStep.* settings, false when the global fixed timestep is off
+	static bool GetGlobalFixedTimestep(float& OutStepSeconds, int32& OutMaxSubsteps);
+	void GetFixedTimestep(float& OutStepSeconds, int32& OutMaxSubsteps) const;
+
+	// Tick every active capability once with DeltaTime
+	void TickActiveCapabilities(float DeltaTime);
+	static bool ConsumeActivationCheckBudget();
+
+	// Owner tick dormancy - disable the owner's tick while it would have nothing to do, wake it when that changes
+	void UpdateOwnerTickDormancy();
+	void WakeOwnerTick();
+
+	// Add or drop every capability of this manager in the per-class profiler counts
+	void SetCountedByProfiler(bool bCounted);
+
 	// Internal capability management
+	void UpdatePolledCapabilityStates();
+	void UpdateDirtyCapabilityStates();
+	void MarkActivationDirty();
+	bool IsPolled(const UBaseCapability* Capability) const;
 	void UpdateCapabilityActivation(UBaseCapability* Capability);
+	void ApplyActivationPredicate(UBaseCapability* Capability, bool bConditionsMet);
 	void ActivateCapability(UBaseCapability* Capability);
 	void DeactivateCapability(UBaseCapability* Capability);
+	void AddLightweightInstance(ULightweightCapability* Capability);
+	void UpdateLightweightActivation(ULightweightCapability* Capability);
+	void ActivateLightweightCapability(ULightweightCapability* Capability);
+	void DeactivateLightweightCapability(ULightweightCapability* Capability);
+	void SleepCapability(UBaseCapability* Capability, float WakeTime, FName WakeEvent, UClass* WakeComponentClass = nullptr);
+	void ClearSleep(UBaseCapability* Capability);
+	void EnqueueCommand(ECapabilityCommandType Type, UObject* Target, UClass* CapabilityClass = nullptr);
+	void EnqueueCommand(FCapabilityCommand&& Command);
+	void AddToTypeIndex(UBaseCapability* Capability);
+	void RemoveFromTypeIndex(UBaseCapability* Capability);
 
 	UPROPERTY()
 	TArray<UBaseCapability*> Capabilities;
@@ -76,6 +283,21 @@ private:
 	UPROPERTY()
 	TArray<UBaseCapability*> ActiveCapabilities;
 
+	// Active capabilities that are asleep, not in ActiveCapabilities while they sleep
+	UPROPERTY()
+	TArray<UBaseCapability*> SleepingCapabilities;
+
+	// Lightweight capabilities in priority order, and the active ones in the same order
+	UPROPERTY()
+	TArray<ULightweightCapability*> LightweightCapabilities;
+
+	UPROPERTY()
+	TArray<ULightweightCapability*> ActiveLightweightCapabilities;
+
+	// Capabilities of each class and its subclasses by capability type id, in priority order.
+	// UBaseCapability itself isn't indexed, Capabilities already holds every capability.
+	TArray<TArray<UBaseCapability*>> CapabilitiesByType;
+
 	// Performance optimization - avoid checking every capability every frame
 	UPROPERTY(EditAnywhere, Category = "Performance")
 	float CapabilityUpdateFrequency = 0.1f; // Check capability states 10 times per second
@@ -83,9 +305,70 @@ private:
 	UPROPERTY(EditAnywhere, Category = "Performance")
 	bool bAutoTick = true; // Whether this component should auto-tick or rely on manual ticking
 
+	UPROPERTY(EditAnywhere, Category = "Performance")
+	bool bUseCapabilityScheduler = true; // Let the world scheduler batch-tick this manager instead of the owner's Tick
+
+	UPROPERTY(EditAnywhere, Category = "Performance")
+	bool bReleaseOwnerTickWhenScheduled = true; // Disable the owner's actor tick while the scheduler ticks this manager
+
+	UPROPERTY(EditAnywhere, Category = "Performance")
+	bool bAllowOwnerTickDormancy = true; // Disable the owner's actor tick while no capability is active and no activation check is pending
+
+	// Tick capabilities in fixed steps of 1 / FixedTimestepHz seconds instead of with the frame's DeltaTime.
+	// The scheduler ticks every manager with the same DeltaTime, so managers with their own fixed timestep are ticked by their owner.
+	UPROPERTY(EditAnywhere, Category = "Performance|Fixed Timestep")
+	bool bUseFixedTimestep = false;
+
+	UPROPERTY(EditAnywhere, Category = "Performance|Fixed Timestep", meta = (ClampMin = "1", EditCondition = "bUseFixedTimestep"))
+	float FixedTimestepHz = 60.0f;
+
+	// Steps run at most per frame, time beyond that is dropped
+	UPROPERTY(EditAnywhere, Category = "Performance|Fixed Timestep", meta = (ClampMin = "1", EditCondition = "bUseFixedTimestep"))
+	int32 MaxFixedSubsteps = 4;
+
+	FCapabilityFixedTimestep FixedTimestep;
+
+	UPROPERTY(Transient)
+	UCapabilitySchedulerSubsystem* Scheduler = nullptr;
+
 	float LastCapabilityUpdateTime = 0.0f;
 
+	// Offset of this manager's periodic activation checks within CapabilityUpdateFrequency, in [0, 1)
+	float ActivationPhase = 0.0f;
+
+	// Cached tick LOD distance
+	float SignificanceDistance = 0.0f;
+	float NextSignificanceUpdateTime = 0.0f;
+
 	// Deferred update system to avoid modifying arrays during iteration
 	bool bCapabilityStateUpdateRequested = false;
 	bool bIsCurrentlyTicking = false;
+
+	// Non-zero while Capabilities is being iterated, structural changes are recorded instead
+	int32 StructuralChangeLockDepth = 0;
+
+	// Command buffer, appended to from worker threads under CommandLock
+	UPROPERTY(Transient)
+	TArray<FCapabilityCommand> PendingCommands;
+	FCriticalSection CommandLock;
+	std::atomic<bool> bHasPendingCommands = false;
+
+	// Event-driven activation - polled capabilities need the periodic pass, dirty ones a targeted re-check
+	int32 NumPolledCapabilities = 0;
+	bool bHasDirtyCapabilities = false;
+
+	// Owner's tick was disabled by UpdateOwnerTickDormancy
+	bool bOwnerTickDormant = false;
+
+	// Capabilities are in the profiler counts, false between EndPlay and the next BeginPlay
+	bool bCountedByProfiler = true;
+
+	// Scheduler bookkeeping
+	int32 SchedulerIndex = INDEX_NONE;
+	int32 LightweightTickIndex = INDEX_NONE;
+	bool bTickedByScheduler = false;
+	bool bReleasedOwnerTick = false;
+	bool bQueuedForActivationUpdate = false;
+	bool bInActivationCheckQueue = false;
+	uint32 ActivationCheckSerial = 0;
 };
\ No newline at end of file
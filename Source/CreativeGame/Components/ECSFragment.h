@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "ECSFragment.generated.h"
+
+/**
+ * Base for component data stored in the archetype store (UECSArchetypeSubsystem) instead of on the component itself.
+ * Derive plain USTRUCTs from this, and point a UBaseComponent's FragmentType at them to opt in.
+ * Fragments are moved around in memory as entities change archetype, so never keep pointers to them across frames.
+ */
+USTRUCT(BlueprintType)
+struct CREATIVEGAME_API FECSFragment
+{
+	GENERATED_BODY()
+};
+
+/**
+ * Handle to an entity in the archetype store - one entity per actor, holding every fragment of its components.
+ */
+USTRUCT(BlueprintType)
+struct CREATIVEGAME_API FECSEntityHandle
+{
+	GENERATED_BODY()
+
+	int32 Index = INDEX_NONE;
+	uint32 Serial = 0;
+
+	bool IsSet() const { return Index != INDEX_NONE; }
+
+	bool operator==(const FECSEntityHandle& Other) const { return Index == Other.Index && Serial == Other.Serial; }
+	bool operator!=(const FECSEntityHandle& Other) const { return !(*this == Other); }
+};
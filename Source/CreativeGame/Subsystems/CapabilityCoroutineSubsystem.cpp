@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapabilityCoroutineSubsystem.h"
+#include "../Capabilities/CapabilityStats.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Coroutines"), STAT_Capabilities_LiveCoroutines, STATGROUP_Capabilities);
+DECLARE_MEMORY_STAT(TEXT("Coroutine Arena Memory"), STAT_Capabilities_CoroutineArenaMemory, STATGROUP_Capabilities);
+
+FCapabilityCoroutineArena::~FCapabilityCoroutineArena()
+{
+	DEC_MEMORY_STAT_BY(STAT_Capabilities_CoroutineArenaMemory, GetReservedBytes());
+	for (void* Block : Blocks)
+	{
+		FMemory::Free(Block);
+	}
+}
+
+void* FCapabilityCoroutineArena::AllocateFrame(const UWorld* World, SIZE_T Size)
+{
+	check(IsInGameThread());
+	INC_DWORD_STAT(STAT_Capabilities_LiveCoroutines);
+
+	const UCapabilityCoroutineSubsystem* Subsystem = World ? World->GetSubsystem<UCapabilityCoroutineSubsystem>() : nullptr;
+	FCapabilityCoroutineArena* Arena = Subsystem ? Subsystem->GetArena() : nullptr;
+
+	const SIZE_T TotalSize = Size + sizeof(FFrameHeader);
+	const int32 SizeClass = static_cast<int32>((TotalSize + Granularity - 1) / Granularity) - 1;
+
+	FFrameHeader* Header = nullptr;
+	if (Arena && SizeClass < NumSizeClasses)
+	{
+		Header = static_cast<FFrameHeader*>(Arena->Allocate(SizeClass));
+		Header->Arena = Arena;
+		Arena->AddRef();
+		++Arena->NumLiveFrames;
+	}
+	else
+	{
+		Header = static_cast<FFrameHeader*>(FMemory::Malloc(TotalSize, alignof(FFrameHeader)));
+		Header->Arena = nullptr;
+	}
+
+	return Header + 1;
+}
+
+void FCapabilityCoroutineArena::FreeFrame(void* Frame, SIZE_T Size)
+{
+	check(IsInGameThread());
+	DEC_DWORD_STAT(STAT_Capabilities_LiveCoroutines);
+
+	FFrameHeader* Header = static_cast<FFrameHeader*>(Frame) - 1;
+	FCapabilityCoroutineArena* Arena = Header->Arena;
+	if (!Arena)
+	{
+		FMemory::Free(Header);
+		return;
+	}
+
+	const SIZE_T TotalSize = Size + sizeof(FFrameHeader);
+	Arena->Free(Header, static_cast<int32>((TotalSize + Granularity - 1) / Granularity) - 1);
+	--Arena->NumLiveFrames;
+
+	// May delete the arena if its world is already gone
+	Arena->Release();
+}
+
+void* FCapabilityCoroutineArena::Allocate(int32 SizeClass)
+{
+	if (FFreeNode* Node = FreeLists[SizeClass])
+	{
+		FreeLists[SizeClass] = Node->Next;
+		return Node;
+	}
+
+	const SIZE_T Bytes = (SizeClass + 1) * Granularity;
+	if (!Cursor || Cursor + Bytes > BlockEnd)
+	{
+		// The tail of the previous block is too small for this size class, just leave it
+		Cursor = static_cast<uint8*>(FMemory::Malloc(BlockSize, alignof(FFrameHeader)));
+		BlockEnd = Cursor + BlockSize;
+		Blocks.Add(Cursor);
+		INC_MEMORY_STAT_BY(STAT_Capabilities_CoroutineArenaMemory, BlockSize);
+	}
+
+	void* Memory = Cursor;
+	Cursor += Bytes;
+	return Memory;
+}
+
+void FCapabilityCoroutineArena::Free(void* Memory, int32 SizeClass)
+{
+	FFreeNode* Node = static_cast<FFreeNode*>(Memory);
+	Node->Next = FreeLists[SizeClass];
+	FreeLists[SizeClass] = Node;
+}
+
+UCapabilityCoroutineSubsystem* UCapabilityCoroutineSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UCapabilityCoroutineSubsystem>() : nullptr;
+}
+
+bool UCapabilityCoroutineSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// Capabilities only run their coroutines in worlds that tick them
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCapabilityCoroutineSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Arena = new FCapabilityCoroutineArena();
+}
+
+void UCapabilityCoroutineSubsystem::Deinitialize()
+{
+	// Frames still alive keep the arena until they're destroyed
+	Arena.SafeRelease();
+
+	Super::Deinitialize();
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Templates/RefCounting.h"
+
+#include "CapabilityCoroutineSubsystem.generated.h"
+
+/**
+ * Size-class allocator for the coroutine frames of UCoroutineCapability.
+ * Frames are carved from large blocks and recycled through per-size free lists, so starting and finishing thousands
+ * of latent behaviours never reaches the general allocator once the arena has warmed up. Game thread only.
+ *
+ * Every live frame holds a reference, so frames of capabilities collected after the world is gone stay valid.
+ */
+class CREATIVEGAME_API FCapabilityCoroutineArena : public FRefCountBase
+{
+public:
+	virtual ~FCapabilityCoroutineArena() override;
+
+	// Coroutine frame allocation, from World's arena when it has one and the general allocator otherwise
+	static void* AllocateFrame(const UWorld* World, SIZE_T Size);
+	static void FreeFrame(void* Frame, SIZE_T Size);
+
+	int32 GetNumLiveFrames() const { return NumLiveFrames; }
+	SIZE_T GetReservedBytes() const { return Blocks.Num() * BlockSize; }
+
+private:
+	// Frames are rounded up to multiples of Granularity, bigger frames than the largest size class use the general allocator
+	static constexpr SIZE_T Granularity = 64;
+	static constexpr int32 NumSizeClasses = 32;
+	static constexpr SIZE_T BlockSize = 64 * 1024;
+
+	// Prepended to every frame so FreeFrame knows where it came from, keeps the frame 16-byte aligned
+	struct alignas(16) FFrameHeader
+	{
+		FCapabilityCoroutineArena* Arena = nullptr;
+	};
+
+	struct FFreeNode
+	{
+		FFreeNode* Next = nullptr;
+	};
+
+	void* Allocate(int32 SizeClass);
+	void Free(void* Memory, int32 SizeClass);
+
+	TArray<void*> Blocks;
+	uint8* Cursor = nullptr;
+	uint8* BlockEnd = nullptr;
+	FFreeNode* FreeLists[NumSizeClasses] = {};
+	int32 NumLiveFrames = 0;
+};
+
+/**
+ * Owns the coroutine frame arena of a world, see UCoroutineCapability.
+ */
+UCLASS()
+class CREATIVEGAME_API UCapabilityCoroutineSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Convenience accessor for the subsystem of a world context object's world
+	static UCapabilityCoroutineSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	FCapabilityCoroutineArena* GetArena() const { return Arena.GetReference(); }
+
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	int32 GetNumLiveCoroutines() const { return Arena ? Arena->GetNumLiveFrames() : 0; }
+
+private:
+	TRefCountPtr<FCapabilityCoroutineArena> Arena;
+};
\ No newline at end of file
@@ -0,0 +1,209 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapabilityPoolSubsystem.h"
+#include "../Capabilities/BaseCapability.h"
+#include "../Capabilities/CapabilityStats.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pool Hits"), STAT_Capabilities_PoolHits, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pool Misses"), STAT_Capabilities_PoolMisses, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pool Releases"), STAT_Capabilities_PoolReleases, STATGROUP_Capabilities);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Capabilities"), STAT_Capabilities_NumPooled, STATGROUP_Capabilities);
+
+static TAutoConsoleVariable<bool> CVarCapabilitiesPooling(
+	TEXT("ECS.Capabilities.Pooling"),
+	true,
+	TEXT("Reuse removed instances of capability classes that set bPoolInstances instead of destroying them."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarCapabilitiesPoolMaxPerClass(
+	TEXT("ECS.Capabilities.PoolMaxPerClass"),
+	64,
+	TEXT("Maximum number of free instances kept per capability class, extra removed instances are destroyed."),
+	ECVF_Default);
+
+// Acquire and release are hot paths - don't flush async loading, transact or dirty packages when moving instances between outers
+static constexpr ERenameFlags PooledRenameFlags = REN_DontCreateRedirectors | REN_ForceNoResetLoaders | REN_NonTransactional | REN_DoNotDirty;
+
+UCapabilityPoolSubsystem* UCapabilityPoolSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UCapabilityPoolSubsystem>() : nullptr;
+}
+
+bool UCapabilityPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// Only worlds where capabilities are added and removed at runtime benefit from pooling
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCapabilityPoolSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	for (const FCapabilityPoolPrewarm& Entry : PrewarmCapabilities)
+	{
+		if (UClass* CapabilityClass = Entry.CapabilityClass.LoadSynchronous())
+		{
+			Prewarm(CapabilityClass, Entry.Count);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Capability pool: could not load prewarm class %s"), *Entry.CapabilityClass.ToString());
+		}
+	}
+}
+
+void UCapabilityPoolSubsystem::Deinitialize()
+{
+	// Pooled instances were never registered, dropping the references is enough for GC to collect them
+	DEC_DWORD_STAT_BY(STAT_Capabilities_NumPooled, NumPooled);
+	FreeCapabilities.Reset();
+	NumPooled = 0;
+
+	Super::Deinitialize();
+}
+
+void UCapabilityPoolSubsystem::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	Super::AddReferencedObjects(InThis, Collector);
+
+	UCapabilityPoolSubsystem* This = CastChecked<UCapabilityPoolSubsystem>(InThis);
+	for (TArray<UBaseCapability*>& Free : This->FreeCapabilities)
+	{
+		Collector.AddReferencedObjects(Free, This);
+	}
+}
+
+void UCapabilityPoolSubsystem::Prewarm(UClass* CapabilityClass, int32 Count)
+{
+	const UBaseCapability* DefaultCapability = CapabilityClass->GetDefaultObject<UBaseCapability>();
+	if (!DefaultCapability->IsPooled())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Capability pool: %s is in PrewarmCapabilities but doesn't set bPoolInstances"), *CapabilityClass->GetName());
+		return;
+	}
+
+	const int32 TypeId = DefaultCapability->GetCapabilityTypeId();
+	if (TypeId >= FreeCapabilities.Num())
+	{
+		FreeCapabilities.SetNum(TypeId + 1);
+	}
+
+	TArray<UBaseCapability*>& Free = FreeCapabilities[TypeId];
+	const int32 NumToCreate = FMath::Min(Count, CVarCapabilitiesPoolMaxPerClass.GetValueOnGameThread()) - Free.Num();
+	for (int32 Index = 0; Index < NumToCreate; ++Index)
+	{
+		Free.Add(NewObject<UBaseCapability>(this, CapabilityClass));
+	}
+
+	NumPooled += FMath::Max(NumToCreate, 0);
+	INC_DWORD_STAT_BY(STAT_Capabilities_NumPooled, FMath::Max(NumToCreate, 0));
+}
+
+UBaseCapability* UCapabilityPoolSubsystem::Acquire(TSubclassOf<UBaseCapability> CapabilityClass, AActor* Owner)
+{
+	if (!CapabilityClass || !CVarCapabilitiesPooling.GetValueOnGameThread())
+	{
+		return nullptr;
+	}
+
+	const UBaseCapability* DefaultCapability = CapabilityClass->GetDefaultObject<UBaseCapability>();
+	if (!DefaultCapability->IsPooled())
+	{
+		return nullptr;
+	}
+
+	const int32 TypeId = DefaultCapability->GetCapabilityTypeId();
+	UBaseCapability* Capability = nullptr;
+	if (FreeCapabilities.IsValidIndex(TypeId))
+	{
+		// Skip anything that was destroyed while parked
+		TArray<UBaseCapability*>& Free = FreeCapabilities[TypeId];
+		while (!Capability && !Free.IsEmpty())
+		{
+			Capability = Free.Pop(EAllowShrinking::No);
+			--NumPooled;
+			DEC_DWORD_STAT(STAT_Capabilities_NumPooled);
+
+			if (!IsValid(Capability))
+			{
+				Capability = nullptr;
+			}
+		}
+	}
+
+	if (!Capability)
+	{
+		++NumMisses;
+		INC_DWORD_STAT(STAT_Capabilities_PoolMisses);
+		return nullptr;
+	}
+
+	++NumHits;
+	INC_DWORD_STAT(STAT_Capabilities_PoolHits);
+
+	Capability->Rename(nullptr, Owner, PooledRenameFlags);
+	return Capability;
+}
+
+bool UCapabilityPoolSubsystem::Release(UBaseCapability* Capability)
+{
+	if (!IsValid(Capability) || !Capability->IsPooled() || !CVarCapabilitiesPooling.GetValueOnGameThread())
+	{
+		return false;
+	}
+
+	// Capabilities removed while their owner or the world goes away are destroyed with it
+	const AActor* Owner = Capability->GetOwner();
+	const UWorld* World = GetWorld();
+	if (!World || World->bIsTearingDown || !IsValid(Owner) || Owner->IsActorBeingDestroyed())
+	{
+		return false;
+	}
+
+	const int32 TypeId = Capability->GetCapabilityTypeId();
+	if (TypeId >= FreeCapabilities.Num())
+	{
+		FreeCapabilities.SetNum(TypeId + 1);
+	}
+
+	TArray<UBaseCapability*>& Free = FreeCapabilities[TypeId];
+	if (Free.Num() >= CVarCapabilitiesPoolMaxPerClass.GetValueOnGameThread())
+	{
+		return false;
+	}
+
+	// Leave play like a destroyed component would, so the next owner's RegisterComponent runs InitializeComponent and BeginPlay again
+	if (Capability->HasBegunPlay())
+	{
+		Capability->EndPlay(EEndPlayReason::RemovedFromWorld);
+	}
+	if (Capability->HasBeenInitialized())
+	{
+		Capability->UninitializeComponent();
+	}
+	if (Capability->IsRegistered())
+	{
+		Capability->UnregisterComponent();
+	}
+
+	Capability->ResetCapability();
+
+	// Parked under the subsystem so the previous owner no longer lists it among its components
+	Capability->Rename(nullptr, this, PooledRenameFlags);
+
+	Free.Add(Capability);
+	++NumPooled;
+	INC_DWORD_STAT(STAT_Capabilities_NumPooled);
+	INC_DWORD_STAT(STAT_Capabilities_PoolReleases);
+	return true;
+}
+
+int32 UCapabilityPoolSubsystem::GetNumPooled(TSubclassOf<UBaseCapability> CapabilityClass) const
+{
+	const int32 TypeId = UBaseCapability::GetCapabilityTypeId(CapabilityClass);
+	return FreeCapabilities.IsValidIndex(TypeId) ? FreeCapabilities[TypeId].Num() : 0;
+}
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+class UBaseCapability;
+
+#include "CapabilityPoolSubsystem.generated.h"
+
+/**
+ * Number of instances of a capability class created in the pool when a level starts.
+ */
+USTRUCT()
+struct FCapabilityPoolPrewarm
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Config)
+	TSoftClassPtr<UBaseCapability> CapabilityClass;
+
+	UPROPERTY(Config)
+	int32 Count = 0;
+};
+
+/**
+ * Per-class free lists of capability instances, so gameplay that keeps adding and removing the same capabilities
+ * (buffs, weapon modes, interaction states) reuses objects instead of churning them through NewObject and GC.
+ *
+ * Only classes that set bPoolInstances are pooled. Removed instances end play, are unregistered, reset through
+ * UBaseCapability::ResetCapability and parked here until a manager adds a capability of the same class again,
+ * which registers them and runs BeginPlay for the new owner.
+ * Pools are pre-warmed at world begin play from PrewarmCapabilities in the [/Script/CreativeGame.CapabilityPoolSubsystem]
+ * section of DefaultGame.ini. Hits and misses are counted in "stat Capabilities".
+ */
+UCLASS(Config = Game)
+class CREATIVEGAME_API UCapabilityPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Convenience accessor for the subsystem of a world context object's world
+	static UCapabilityPoolSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
+	// Pooled instance of CapabilityClass moved to Owner, or null when the class isn't pooled or its pool is empty
+	UBaseCapability* Acquire(TSubclassOf<UBaseCapability> CapabilityClass, AActor* Owner);
+
+	// Reset and keep a capability its manager no longer uses, returns false if the caller should destroy it instead
+	bool Release(UBaseCapability* Capability);
+
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	int32 GetNumPooled(TSubclassOf<UBaseCapability> CapabilityClass) const;
+
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	int32 GetNumPoolHits() const { return NumHits; }
+
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	int32 GetNumPoolMisses() const { return NumMisses; }
+
+private:
+	void Prewarm(UClass* CapabilityClass, int32 Count);
+
+	// Classes and instance counts created at world begin play
+	UPROPERTY(Config)
+	TArray<FCapabilityPoolPrewarm> PrewarmCapabilities;
+
+	// Free instances indexed by capability type id, referenced through AddReferencedObjects
+	TArray<TArray<UBaseCapability*>> FreeCapabilities;
+	int32 NumPooled = 0;
+
+	int32 NumHits = 0;
+	int32 NumMisses = 0;
+};
@@ -0,0 +1,1018 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapabilitySchedulerSubsystem.h"
+#include "../Capabilities/BaseCapability.h"
+#include "../Capabilities/CapabilityActivationPredicate.h"
+#include "../Capabilities/CapabilityDispatch.h"
+#include "../Capabilities/CapabilityProfiler.h"
+#include "../Capabilities/CapabilityStats.h"
+#include "../Components/BaseComponent.h"
+#include "../Components/CapabilityManagerComponent.h"
+#include "Async/ParallelFor.h"
+#include "CoreGlobals.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Scheduler Tick"), STAT_CapabilityScheduler_Tick, STATGROUP_Capabilities);
+DECLARE_CYCLE_STAT(TEXT("Scheduler Activation Updates"), STAT_CapabilityScheduler_ActivationUpdates, STATGROUP_Capabilities);
+DECLARE_CYCLE_STAT(TEXT("Scheduler Tick Capabilities"), STAT_CapabilityScheduler_TickCapabilities, STATGROUP_Capabilities);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Activation Check Lag (ms)"), STAT_CapabilityScheduler_ActivationCheckLag, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Queued Activation Updates"), STAT_CapabilityScheduler_NumActivationUpdates, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scheduled Managers"), STAT_CapabilityScheduler_NumManagers, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scheduled Capability Classes"), STAT_CapabilityScheduler_NumBuckets, STATGROUP_Capabilities);
+DECLARE_CYCLE_STAT(TEXT("Scheduler Activation Predicates"), STAT_CapabilityScheduler_ActivationPredicates, STATGROUP_Capabilities);
+DECLARE_CYCLE_STAT(TEXT("Scheduler Parallel Wave"), STAT_CapabilityScheduler_ParallelWave, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ticked Capabilities"), STAT_CapabilityScheduler_NumTicked, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Worker Ticked Capabilities"), STAT_CapabilityScheduler_NumWorkerTicked, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Parallel Waves"), STAT_CapabilityScheduler_NumParallelWaves, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scheduler Fixed Steps"), STAT_CapabilityScheduler_NumFixedSteps, STATGROUP_Capabilities);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Scheduler Dropped Time (ms)"), STAT_CapabilityScheduler_FixedStepDroppedMs, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Budget Deferred Classes"), STAT_CapabilityScheduler_NumBudgetDeferred, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Starved Capability Classes"), STAT_CapabilityScheduler_NumStarved, STATGROUP_Capabilities);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Frame Time Saved (ms)"), STAT_CapabilityScheduler_FrameTimeSaved, STATGROUP_Capabilities);
+
+static TAutoConsoleVariable<bool> CVarCapabilitySchedulerEnabled(
+	TEXT("ECS.Scheduler.Enabled"),
+	true,
+	TEXT("When enabled, the world capability scheduler batch-ticks every registered capability manager.\n")
+	TEXT("When disabled, managers fall back to being ticked by their owning actors."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<bool> CVarCapabilitySchedulerParallelTick(
+	TEXT("ECS.Scheduler.ParallelTick"),
+	true,
+	TEXT("When enabled, capabilities declaring bTickOnWorkerThread are ticked in parallel on worker threads."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarCapabilitySchedulerParallelMinBatch(
+	TEXT("ECS.Scheduler.ParallelMinBatch"),
+	32,
+	TEXT("Parallel waves with fewer capabilities than this are ticked on the game thread, where dispatch would cost more than it saves."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarCapabilitySchedulerTickBudgetMs(
+	TEXT("ECS.Scheduler.TickBudgetMs"),
+	0.0f,
+	TEXT("Game thread time in ms capability ticking may use per frame, 0 disables the budget.\n")
+	TEXT("Capability classes tick in priority order, classes left over roll over to the next frame with the accumulated DeltaTime.\n")
+	TEXT("The highest priority class always ticks."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarCapabilitySchedulerStarvationFrames(
+	TEXT("ECS.Scheduler.StarvationFrames"),
+	30,
+	TEXT("Capability classes deferred by the tick budget for more than this many frames in a row are reported as starved."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorld CapabilitySchedulerReportCommand(
+	TEXT("ECS.Scheduler.Report"),
+	TEXT("Logs how much game thread time batched capability ticking saves compared with per-actor ticking.\n")
+	TEXT("Run the game with ECS.Scheduler.Enabled toggled for a few seconds in each mode to sample both."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UCapabilitySchedulerSubsystem* Scheduler = World ? World->GetSubsystem<UCapabilitySchedulerSubsystem>() : nullptr)
+		{
+			Scheduler->LogReport();
+		}
+	}));
+
+// Weight of the newest frame in the moving averages used for reporting
+static constexpr float FrameTimeSmoothing = 0.05f;
+
+void FCapabilitySchedulerTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Scheduler && TickType != LEVELTICK_ViewportsOnly)
+	{
+		Scheduler->TickScheduler(DeltaTime);
+	}
+}
+
+FString FCapabilitySchedulerTickFunction::DiagnosticMessage()
+{
+	return TEXT("FCapabilitySchedulerTickFunction");
+}
+
+FName FCapabilitySchedulerTickFunction::DiagnosticContext(bool bDetailed)
+{
+	return FName(TEXT("CapabilityScheduler"));
+}
+
+bool UCapabilitySchedulerSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// Capabilities only tick in worlds that actually begin play
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCapabilitySchedulerSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// One tick function for the whole world, in the same tick group the ECS actors used to tick in
+	SchedulerTickFunction.Scheduler = this;
+	SchedulerTickFunction.bCanEverTick = true;
+	SchedulerTickFunction.bStartWithTickEnabled = true;
+	SchedulerTickFunction.TickGroup = TG_PrePhysics;
+	SchedulerTickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+
+	bSchedulerEnabled = CVarCapabilitySchedulerEnabled.GetValueOnGameThread();
+	bActivationPollingForced = UCapabilityManagerComponent::IsActivationPollingForced();
+}
+
+void UCapabilitySchedulerSubsystem::Deinitialize()
+{
+	if (SchedulerTickFunction.IsTickFunctionRegistered())
+	{
+		SchedulerTickFunction.UnRegisterTickFunction();
+	}
+	SchedulerTickFunction.Scheduler = nullptr;
+
+	Managers.Reset();
+	PendingActivationUpdates.Reset();
+	ActivationCheckQueue.Reset();
+	TickBuckets.Reset();
+	BucketIndexByClassAndPriority.Reset();
+	BucketTickOrder.Reset();
+	TickWaves.Reset();
+	LightweightTickManagers.Reset();
+	NumRegisteredManagers = 0;
+
+	Super::Deinitialize();
+}
+
+void UCapabilitySchedulerSubsystem::RegisterManager(UCapabilityManagerComponent* Manager)
+{
+	if (!IsValid(Manager) || Manager->SchedulerIndex != INDEX_NONE)
+	{
+		return;
+	}
+
+	Manager->SchedulerIndex = Managers.Add(Manager);
+	++NumRegisteredManagers;
+
+	// Capabilities may already have been activated before the manager began play
+	for (UBaseCapability* Capability : Manager->ActiveCapabilities)
+	{
+		AddToTickBucket(Capability);
+	}
+	if (!Manager->ActiveLightweightCapabilities.IsEmpty())
+	{
+		AddLightweightTickManager(Manager);
+	}
+
+	Manager->SetTickedByScheduler(bSchedulerEnabled);
+
+	if (bSchedulerEnabled)
+	{
+		ScheduleActivationCheck(Manager);
+	}
+}
+
+void UCapabilitySchedulerSubsystem::UnregisterManager(UCapabilityManagerComponent* Manager)
+{
+	if (!Manager || !Managers.IsValidIndex(Manager->SchedulerIndex) || Managers[Manager->SchedulerIndex] != Manager)
+	{
+		return;
+	}
+
+	for (UBaseCapability* Capability : Manager->ActiveCapabilities)
+	{
+		RemoveFromTickBucket(Capability);
+	}
+	RemoveLightweightTickManager(Manager);
+
+	if (Manager->bQueuedForActivationUpdate)
+	{
+		// Keep the queue stable in case it is being processed, the slot is skipped
+		const int32 QueueIndex = PendingActivationUpdates.Find(Manager);
+		if (QueueIndex != INDEX_NONE)
+		{
+			PendingActivationUpdates[QueueIndex] = nullptr;
+		}
+		Manager->bQueuedForActivationUpdate = false;
+	}
+
+	// Its queued activation check is skipped once the serial no longer matches
+	Manager->bInActivationCheckQueue = false;
+	++Manager->ActivationCheckSerial;
+
+	const int32 Index = Manager->SchedulerIndex;
+	Manager->SchedulerIndex = INDEX_NONE;
+	Manager->bTickedByScheduler = false;
+	--NumRegisteredManagers;
+
+	Managers.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	if (Managers.IsValidIndex(Index))
+	{
+		Managers[Index]->SchedulerIndex = Index;
+	}
+}
+
+void UCapabilitySchedulerSubsystem::AddToTickBucket(UBaseCapability* Capability)
+{
+	if (!IsValid(Capability) || Capability->SchedulerSlotIndex != INDEX_NONE)
+	{
+		return;
+	}
+
+	UClass* CapabilityClass = Capability->GetClass();
+	const TPair<UClass*, int32> BucketKey(CapabilityClass, Capability->GetPriority());
+	int32 BucketIndex = INDEX_NONE;
+	if (const int32* ExistingIndex = BucketIndexByClassAndPriority.Find(BucketKey))
+	{
+		BucketIndex = *ExistingIndex;
+	}
+	else
+	{
+		const UBaseCapability* DefaultCapability = GetDefault<UBaseCapability>(CapabilityClass);
+		BucketIndex = TickBuckets.AddDefaulted();
+		FCapabilityTickBucket& NewBucket = TickBuckets[BucketIndex];
+		NewBucket.CapabilityClass = CapabilityClass;
+		NewBucket.Priority = BucketKey.Value;
+		NewBucket.bTickOnWorkerThread = DefaultCapability->CanTickOnWorkerThread();
+		NewBucket.bUsesTickLOD = DefaultCapability->UsesTickLOD();
+		for (const TSubclassOf<UBaseComponent>& ComponentClass : DefaultCapability->GetReadComponents())
+		{
+			NewBucket.ReadComponents.AddUnique(ComponentClass.Get());
+		}
+		for (const TSubclassOf<UBaseComponent>& ComponentClass : DefaultCapability->GetWriteComponents())
+		{
+			NewBucket.WriteComponents.AddUnique(ComponentClass.Get());
+		}
+		BucketIndexByClassAndPriority.Add(BucketKey, BucketIndex);
+		BucketTickOrder.Add(BucketIndex);
+		bBucketOrderDirty = true;
+	}
+
+	// Appending is safe while ticking - buckets are iterated by index up to their size at the start of the pass
+	FCapabilityTickBucket& Bucket = TickBuckets[BucketIndex];
+	Capability->SchedulerBucketIndex = BucketIndex;
+	Capability->SchedulerSlotIndex = Bucket.Capabilities.Add(Capability);
+
+	// Two instances of one worker-thread class on the same owner would write the same components concurrently
+	Capability->bSchedulerForceGameThread = false;
+	if (Bucket.bTickOnWorkerThread && Capability->OwningManager)
+	{
+		int32 NumSameClass = 0;
+		for (const UBaseCapability* ActiveCapability : Capability->OwningManager->ActiveCapabilities)
+		{
+			NumSameClass += (ActiveCapability && ActiveCapability->GetClass() == CapabilityClass) ? 1 : 0;
+		}
+		Capability->bSchedulerForceGameThread = NumSameClass > 1;
+	}
+}
+
+void UCapabilitySchedulerSubsystem::EnqueueWorkerStateUpdateRequest(UCapabilityManagerComponent* Manager)
+{
+	WorkerStateUpdateRequests.Enqueue(Manager);
+}
+
+void UCapabilitySchedulerSubsystem::FlushWorkerRequests()
+{
+	UCapabilityManagerComponent* Manager = nullptr;
+	while (WorkerStateUpdateRequests.Dequeue(Manager))
+	{
+		// The manager applies its recorded commands when the activation queue is processed
+		if (IsValid(Manager))
+		{
+			QueueActivationUpdate(Manager);
+		}
+	}
+}
+
+void UCapabilitySchedulerSubsystem::QueueActivationUpdate(UCapabilityManagerComponent* Manager)
+{
+	if (!Manager || Manager->bQueuedForActivationUpdate || Manager->SchedulerIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	Manager->bQueuedForActivationUpdate = true;
+	PendingActivationUpdates.Add(Manager);
+}
+
+void UCapabilitySchedulerSubsystem::ProcessActivationQueue()
+{
+	SCOPE_CYCLE_COUNTER(STAT_CapabilityScheduler_ActivationUpdates);
+
+	// Managers queued by activation changes made here wait for the next pass
+	const int32 NumToProcess = PendingActivationUpdates.Num();
+	for (int32 Index = 0; Index < NumToProcess; ++Index)
+	{
+		if (UCapabilityManagerComponent* Manager = PendingActivationUpdates[Index])
+		{
+			Manager->bQueuedForActivationUpdate = false;
+			Manager->RunPendingActivationUpdates();
+		}
+	}
+
+	PendingActivationUpdates.RemoveAt(0, NumToProcess, EAllowShrinking::No);
+	INC_DWORD_STAT_BY(STAT_CapabilityScheduler_NumActivationUpdates, NumToProcess);
+
+	// Managers processed above queued their predicate capabilities, evaluate them class by class
+	EvaluateActivationPredicates();
+}
+
+void UCapabilitySchedulerSubsystem::QueuePredicateEvaluation(UBaseCapability* Capability)
+{
+	const int32 TypeId = Capability ? Capability->GetCapabilityTypeId() : INDEX_NONE;
+	if (TypeId == INDEX_NONE || Capability->bPredicateQueued)
+	{
+		return;
+	}
+
+	if (TypeId >= PredicateBatches.Num())
+	{
+		PredicateBatches.SetNum(TypeId + 1);
+	}
+
+	Capability->bPredicateQueued = true;
+	FCapabilityPredicateBatch& Batch = PredicateBatches[TypeId];
+	Batch.Pending.Add(Capability);
+	if (!Batch.bQueued)
+	{
+		Batch.bQueued = true;
+		QueuedPredicateBatches.Add(TypeId);
+	}
+}
+
+void UCapabilitySchedulerSubsystem::EvaluateActivationPredicates()
+{
+	if (QueuedPredicateBatches.IsEmpty())
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_CapabilityScheduler_ActivationPredicates);
+
+	// Capabilities queued by activation changes made here wait for the next pass
+	const int32 NumBatches = QueuedPredicateBatches.Num();
+	for (int32 Index = 0; Index < NumBatches; ++Index)
+	{
+		FCapabilityPredicateBatch& Batch = PredicateBatches[QueuedPredicateBatches[Index]];
+		Batch.bQueued = false;
+
+		// Removed or pooled capabilities lost their queued flag, and a capability queued twice is only evaluated once
+		PredicateWork.Reset();
+		for (const TWeakObjectPtr<UBaseCapability>& WeakCapability : Batch.Pending)
+		{
+			UBaseCapability* Capability = WeakCapability.Get();
+			if (IsValid(Capability) && Capability->bPredicateQueued)
+			{
+				Capability->bPredicateQueued = false;
+				if (Capability->OwningManager)
+				{
+					PredicateWork.Add(Capability);
+				}
+			}
+		}
+		Batch.Pending.Reset();
+
+		if (PredicateWork.IsEmpty())
+		{
+			continue;
+		}
+
+		FCapabilityPredicateProgram::Get(PredicateWork[0])->Evaluate(PredicateWork, PredicateResults);
+
+		// Activation callbacks may queue more capabilities, Batch must not be used past this point
+		for (int32 WorkIndex = 0; WorkIndex < PredicateWork.Num(); ++WorkIndex)
+		{
+			UBaseCapability* Capability = PredicateWork[WorkIndex];
+			if (IsValid(Capability) && Capability->OwningManager)
+			{
+				Capability->OwningManager->ApplyActivationPredicate(Capability, PredicateResults[WorkIndex] != 0);
+			}
+		}
+	}
+
+	QueuedPredicateBatches.RemoveAt(0, NumBatches, EAllowShrinking::No);
+}
+
+void UCapabilitySchedulerSubsystem::ScheduleActivationCheck(UCapabilityManagerComponent* Manager)
+{
+	if (!bSchedulerEnabled || !Manager || Manager->bInActivationCheckQueue || !Manager->NeedsPeriodicActivationUpdate())
+	{
+		return;
+	}
+
+	// First check at the manager's own phase, so managers registered together are spread over the period
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	PushActivationCheck(Manager, CurrentTime + Manager->ActivationPhase * Manager->CapabilityUpdateFrequency);
+}
+
+void UCapabilitySchedulerSubsystem::PushActivationCheck(UCapabilityManagerComponent* Manager, float DueTime)
+{
+	Manager->bInActivationCheckQueue = true;
+
+	FCapabilityActivationCheck Check;
+	Check.DueTime = DueTime;
+	Check.Manager = Manager;
+	Check.Serial = Manager->ActivationCheckSerial;
+	ActivationCheckQueue.HeapPush(MoveTemp(Check));
+}
+
+void UCapabilitySchedulerSubsystem::ScheduleAllActivationChecks()
+{
+	for (UCapabilityManagerComponent* Manager : Managers)
+	{
+		ScheduleActivationCheck(Manager);
+	}
+}
+
+void UCapabilitySchedulerSubsystem::RunDueActivationChecks(float CurrentTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CapabilityScheduler_ActivationUpdates);
+
+	while (!ActivationCheckQueue.IsEmpty() && ActivationCheckQueue.HeapTop().DueTime <= CurrentTime)
+	{
+		const FCapabilityActivationCheck& Top = ActivationCheckQueue.HeapTop();
+		UCapabilityManagerComponent* Manager = Top.Manager.Get();
+		const bool bStale = !Manager || Manager->ActivationCheckSerial != Top.Serial;
+
+		// Stale entries are free to drop, live ones wait for next frame once the budget is spent
+		if (!bStale && !UCapabilityManagerComponent::ConsumeActivationCheckBudget())
+		{
+			break;
+		}
+
+		FCapabilityActivationCheck Check;
+		ActivationCheckQueue.HeapPop(Check, EAllowShrinking::No);
+		if (bStale)
+		{
+			continue;
+		}
+
+		Manager->bInActivationCheckQueue = false;
+		if (Manager->NeedsPeriodicActivationUpdate())
+		{
+			Manager->UpdatePolledCapabilityStates();
+
+			// Reschedule relative to now, postponed checks keep their spacing instead of bunching up behind the budget
+			PushActivationCheck(Manager, CurrentTime + Manager->CapabilityUpdateFrequency);
+		}
+	}
+
+	// How far behind the oldest due check is, non-zero means the per-frame budget is too small
+	const float LagMs = ActivationCheckQueue.IsEmpty() ? 0.0f : FMath::Max(0.0f, CurrentTime - ActivationCheckQueue.HeapTop().DueTime) * 1000.0f;
+	SET_FLOAT_STAT(STAT_CapabilityScheduler_ActivationCheckLag, LagMs);
+}
+
+void UCapabilitySchedulerSubsystem::RemoveFromTickBucket(UBaseCapability* Capability)
+{
+	if (!Capability || !TickBuckets.IsValidIndex(Capability->SchedulerBucketIndex))
+	{
+		return;
+	}
+
+	FCapabilityTickBucket& Bucket = TickBuckets[Capability->SchedulerBucketIndex];
+	const int32 SlotIndex = Capability->SchedulerSlotIndex;
+	Capability->SchedulerBucketIndex = INDEX_NONE;
+	Capability->SchedulerSlotIndex = INDEX_NONE;
+
+	if (!Bucket.Capabilities.IsValidIndex(SlotIndex) || Bucket.Capabilities[SlotIndex] != Capability)
+	{
+		return;
+	}
+
+	if (bTickingBuckets)
+	{
+		Bucket.Capabilities[SlotIndex] = nullptr;
+		Bucket.bNeedsCompaction = true;
+		bAnyBucketNeedsCompaction = true;
+		return;
+	}
+
+	Bucket.Capabilities.RemoveAtSwap(SlotIndex, 1, EAllowShrinking::No);
+	if (Bucket.Capabilities.IsValidIndex(SlotIndex))
+	{
+		Bucket.Capabilities[SlotIndex]->SchedulerSlotIndex = SlotIndex;
+	}
+}
+
+void UCapabilitySchedulerSubsystem::TickScheduler(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CapabilityScheduler_Tick);
+
+	FCapabilityProfiler::PublishCounts();
+
+	const bool bWantsEnabled = CVarCapabilitySchedulerEnabled.GetValueOnGameThread();
+	if (bWantsEnabled != bSchedulerEnabled)
+	{
+		SetSchedulerEnabled(bWantsEnabled);
+	}
+
+	if (!bSchedulerEnabled)
+	{
+		// Owning actors tick their managers themselves, only keep sampling for the report
+		SampleFrameTime(0.0f);
+		return;
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// Only get time once per frame for every manager
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	SET_DWORD_STAT(STAT_CapabilityScheduler_NumActivationUpdates, 0);
+
+	// Forcing polling turns every manager with capabilities into a polled one
+	const bool bPollingForced = UCapabilityManagerComponent::IsActivationPollingForced();
+	if (bPollingForced != bActivationPollingForced)
+	{
+		bActivationPollingForced = bPollingForced;
+		ScheduleAllActivationChecks();
+	}
+
+	// Event-driven managers never enter the check queue and only show up in the activation queue
+	RunDueActivationChecks(CurrentTime);
+
+	ProcessActivationQueue();
+
+	// The budget covers the whole frame, including every fixed step
+	const float TickBudgetMs = CVarCapabilitySchedulerTickBudgetMs.GetValueOnGameThread();
+	TickBudgetEndCycles = TickBudgetMs > 0.0f ? StartCycles + static_cast<uint64>(TickBudgetMs / (FPlatformTime::GetSecondsPerCycle64() * 1000.0)) : 0;
+
+	float StepSeconds = 0.0f;
+	int32 MaxSubsteps = 0;
+	if (!UCapabilityManagerComponent::GetGlobalFixedTimestep(StepSeconds, MaxSubsteps))
+	{
+		FixedTimestep = FCapabilityFixedTimestep();
+		InterpolationAlpha = 1.0f;
+
+		TickCapabilityBuckets(DeltaTime);
+
+		// Deferred updates requested while capabilities were ticking
+		ProcessActivationQueue();
+	}
+	else
+	{
+		const int32 NumSteps = FixedTimestep.Advance(DeltaTime, StepSeconds, MaxSubsteps);
+		INC_DWORD_STAT_BY(STAT_CapabilityScheduler_NumFixedSteps, NumSteps);
+		INC_FLOAT_STAT_BY(STAT_CapabilityScheduler_FixedStepDroppedMs, FixedTimestep.DroppedTime * 1000.0f);
+
+		for (int32 Step = 0; Step < NumSteps; ++Step)
+		{
+			TickCapabilityBuckets(StepSeconds);
+
+			// Every step sees the activation changes made by the previous one
+			ProcessActivationQueue();
+		}
+
+		InterpolationAlpha = FixedTimestep.GetAlpha(StepSeconds);
+	}
+
+	SET_DWORD_STAT(STAT_CapabilityScheduler_NumManagers, NumRegisteredManagers);
+	SET_DWORD_STAT(STAT_CapabilityScheduler_NumBuckets, TickBuckets.Num());
+
+	SampleFrameTime(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+}
+
+void UCapabilitySchedulerSubsystem::TickCapabilityBuckets(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CapabilityScheduler_TickCapabilities);
+
+	if (bBucketOrderDirty)
+	{
+		RebuildTickWaves();
+	}
+
+	int32 NumTicked = 0;
+	int32 NumParallelWaves = 0;
+	int32 NumDeferred = 0;
+	bTickingBuckets = true;
+
+	// Waves are only rebuilt between frames, new buckets created while ticking wait until next frame
+	const bool bAllowParallel = CVarCapabilitySchedulerParallelTick.GetValueOnGameThread();
+	for (int32 WaveIndex = 0; WaveIndex < TickWaves.Num(); ++WaveIndex)
+	{
+		const FCapabilityTickWave& Wave = TickWaves[WaveIndex];
+
+		// Waves are in priority order, so everything from here on is lower priority than what already ticked
+		if (WaveIndex > 0 && IsTickBudgetExhausted())
+		{
+			for (const int32 BucketIndex : Wave.BucketIndices)
+			{
+				DeferBucket(BucketIndex, DeltaTime);
+				++NumDeferred;
+			}
+			continue;
+		}
+
+		if (Wave.bParallel && bAllowParallel)
+		{
+			NumTicked += TickParallelWave(Wave, DeltaTime);
+			++NumParallelWaves;
+			continue;
+		}
+
+		for (const int32 BucketIndex : Wave.BucketIndices)
+		{
+			NumTicked += TickSerialBucket(BucketIndex, TakeDeferredDeltaTime(BucketIndex, DeltaTime));
+		}
+	}
+
+	TickLightweightCapabilities(DeltaTime);
+
+	bTickingBuckets = false;
+
+	if (bAnyBucketNeedsCompaction)
+	{
+		CompactTickBuckets();
+	}
+
+	SET_DWORD_STAT(STAT_CapabilityScheduler_NumTicked, NumTicked);
+	SET_DWORD_STAT(STAT_CapabilityScheduler_NumParallelWaves, NumParallelWaves);
+	SET_DWORD_STAT(STAT_CapabilityScheduler_NumBudgetDeferred, NumDeferred);
+	SET_DWORD_STAT(STAT_CapabilityScheduler_NumStarved, NumStarvedBuckets);
+}
+
+bool UCapabilitySchedulerSubsystem::IsTickBudgetExhausted() const
+{
+	return TickBudgetEndCycles != 0 && FPlatformTime::Cycles64() >= TickBudgetEndCycles;
+}
+
+float UCapabilitySchedulerSubsystem::TakeDeferredDeltaTime(int32 BucketIndex, float DeltaTime)
+{
+	FCapabilityTickBucket& Bucket = TickBuckets[BucketIndex];
+	if (Bucket.DeferredFrames == 0)
+	{
+		return DeltaTime;
+	}
+
+	if (Bucket.bStarved)
+	{
+		Bucket.bStarved = false;
+		--NumStarvedBuckets;
+	}
+
+	const float TotalDeltaTime = DeltaTime + Bucket.DeferredDeltaTime;
+	Bucket.DeferredDeltaTime = 0.0f;
+	Bucket.DeferredFrames = 0;
+	return TotalDeltaTime;
+}
+
+void UCapabilitySchedulerSubsystem::DeferBucket(int32 BucketIndex, float DeltaTime)
+{
+	FCapabilityTickBucket& Bucket = TickBuckets[BucketIndex];
+	if (Bucket.Capabilities.IsEmpty())
+	{
+		// Nothing missed a tick, capabilities activating later start with a normal DeltaTime
+		TakeDeferredDeltaTime(BucketIndex, 0.0f);
+		return;
+	}
+
+	Bucket.DeferredDeltaTime += DeltaTime;
+	++Bucket.DeferredFrames;
+
+	if (!Bucket.bStarved && Bucket.DeferredFrames > CVarCapabilitySchedulerStarvationFrames.GetValueOnGameThread())
+	{
+		Bucket.bStarved = true;
+		++NumStarvedBuckets;
+		UE_LOG(LogTemp, Warning, TEXT("Capability scheduler: %s has been deferred by the tick budget for %d frames (%.2fs), %d capabilities starved"),
+			*GetNameSafe(Bucket.CapabilityClass), Bucket.DeferredFrames, Bucket.DeferredDeltaTime, Bucket.Capabilities.Num());
+	}
+}
+
+int32 UCapabilitySchedulerSubsystem::TickSerialBucket(int32 BucketIndex, float DeltaTime)
+{
+	int32 NumTicked = 0;
+
+	// Every capability in a bucket has the same class, so one scope covers the whole bucket
+	const int32 NumCapabilities = TickBuckets[BucketIndex].Capabilities.Num();
+	if (NumCapabilities == 0)
+	{
+		return 0;
+	}
+	CAPABILITY_PROFILE_SCOPE(GetDefault<UBaseCapability>(TickBuckets[BucketIndex].CapabilityClass), Tick);
+
+	// Index based loop - the bucket may grow while capabilities tick, new entries wait until next frame
+	const bool bWorkerThreadClass = TickBuckets[BucketIndex].bTickOnWorkerThread;
+	const bool bUsesTickLOD = TickBuckets[BucketIndex].bUsesTickLOD;
+	for (int32 SlotIndex = 0; SlotIndex < NumCapabilities; ++SlotIndex)
+	{
+		UBaseCapability* Capability = TickBuckets[BucketIndex].Capabilities[SlotIndex];
+		if (!IsValid(Capability))
+		{
+			continue;
+		}
+
+		float CapabilityDeltaTime = DeltaTime;
+		if (bUsesTickLOD && Capability->OwningManager && !Capability->OwningManager->ShouldTickCapability(Capability, DeltaTime, CapabilityDeltaTime))
+		{
+			continue;
+		}
+
+		if (bWorkerThreadClass)
+		{
+			Capability->TickCapabilityConcurrent(CapabilityDeltaTime);
+		}
+		else
+		{
+			FCapabilityDispatch::TickCapability(Capability, CapabilityDeltaTime);
+		}
+		++NumTicked;
+	}
+
+	return NumTicked;
+}
+
+int32 UCapabilitySchedulerSubsystem::TickParallelWave(const FCapabilityTickWave& Wave, float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CapabilityScheduler_ParallelWave);
+
+	ParallelWork.Reset();
+	GameThreadWork.Reset();
+	for (const int32 BucketIndex : Wave.BucketIndices)
+	{
+		const bool bUsesTickLOD = TickBuckets[BucketIndex].bUsesTickLOD;
+		const float BucketDeltaTime = TakeDeferredDeltaTime(BucketIndex, DeltaTime);
+		for (UBaseCapability* Capability : TickBuckets[BucketIndex].Capabilities)
+		{
+			if (!IsValid(Capability))
+			{
+				continue;
+			}
+
+			// Tick LOD is decided here on the game thread, workers only read the resulting DeltaTime
+			Capability->ScheduledDeltaTime = BucketDeltaTime;
+			if (bUsesTickLOD && Capability->OwningManager && !Capability->OwningManager->ShouldTickCapability(Capability, BucketDeltaTime, Capability->ScheduledDeltaTime))
+			{
+				continue;
+			}
+
+			(Capability->bSchedulerForceGameThread ? GameThreadWork : ParallelWork).Add(Capability);
+		}
+	}
+
+	// Nothing can activate, deactivate or be added on the worker threads, so the work list stays valid throughout
+	const bool bSingleThread = ParallelWork.Num() < CVarCapabilitySchedulerParallelMinBatch.GetValueOnGameThread();
+	ParallelFor(ParallelWork.Num(), [this](int32 Index)
+	{
+		CAPABILITY_PROFILE_SCOPE(ParallelWork[Index], Tick);
+		ParallelWork[Index]->TickCapabilityConcurrent(ParallelWork[Index]->ScheduledDeltaTime);
+	}, bSingleThread ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	// Sync point - duplicates that couldn't join the wave and requests made from the workers
+	for (UBaseCapability* Capability : GameThreadWork)
+	{
+		CAPABILITY_PROFILE_SCOPE(Capability, Tick);
+		Capability->TickCapabilityConcurrent(Capability->ScheduledDeltaTime);
+	}
+	FlushWorkerRequests();
+
+	INC_DWORD_STAT_BY(STAT_CapabilityScheduler_NumWorkerTicked, bSingleThread ? 0 : ParallelWork.Num());
+	return ParallelWork.Num() + GameThreadWork.Num();
+}
+
+void UCapabilitySchedulerSubsystem::AddLightweightTickManager(UCapabilityManagerComponent* Manager)
+{
+	if (!Manager || Manager->LightweightTickIndex != INDEX_NONE || Manager->SchedulerIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	Manager->LightweightTickIndex = LightweightTickManagers.Add(Manager);
+}
+
+void UCapabilitySchedulerSubsystem::RemoveLightweightTickManager(UCapabilityManagerComponent* Manager)
+{
+	if (!Manager || !LightweightTickManagers.IsValidIndex(Manager->LightweightTickIndex))
+	{
+		return;
+	}
+
+	const int32 Index = Manager->LightweightTickIndex;
+	Manager->LightweightTickIndex = INDEX_NONE;
+
+	if (bTickingBuckets)
+	{
+		// Keep the list stable while it may be iterated
+		LightweightTickManagers[Index] = nullptr;
+		bLightweightTickManagersNeedCompaction = true;
+		return;
+	}
+
+	LightweightTickManagers.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	if (LightweightTickManagers.IsValidIndex(Index) && LightweightTickManagers[Index])
+	{
+		LightweightTickManagers[Index]->LightweightTickIndex = Index;
+	}
+}
+
+void UCapabilitySchedulerSubsystem::TickLightweightCapabilities(float DeltaTime)
+{
+	// Index based loop - managers added while ticking wait until next frame
+	const int32 NumManagers = LightweightTickManagers.Num();
+	for (int32 Index = 0; Index < NumManagers; ++Index)
+	{
+		if (UCapabilityManagerComponent* Manager = LightweightTickManagers[Index])
+		{
+			Manager->TickLightweightCapabilities(DeltaTime);
+		}
+	}
+
+	if (bLightweightTickManagersNeedCompaction)
+	{
+		bLightweightTickManagersNeedCompaction = false;
+		LightweightTickManagers.RemoveAll([](const UCapabilityManagerComponent* Manager) { return Manager == nullptr; });
+		for (int32 Index = 0; Index < LightweightTickManagers.Num(); ++Index)
+		{
+			LightweightTickManagers[Index]->LightweightTickIndex = Index;
+		}
+	}
+}
+
+void UCapabilitySchedulerSubsystem::CompactTickBuckets()
+{
+	for (FCapabilityTickBucket& Bucket : TickBuckets)
+	{
+		if (!Bucket.bNeedsCompaction)
+		{
+			continue;
+		}
+
+		Bucket.Capabilities.RemoveAll([](const UBaseCapability* Capability) { return Capability == nullptr; });
+		for (int32 SlotIndex = 0; SlotIndex < Bucket.Capabilities.Num(); ++SlotIndex)
+		{
+			Bucket.Capabilities[SlotIndex]->SchedulerSlotIndex = SlotIndex;
+		}
+		Bucket.bNeedsCompaction = false;
+	}
+
+	bAnyBucketNeedsCompaction = false;
+}
+
+void UCapabilitySchedulerSubsystem::RebuildTickWaves()
+{
+	// Higher priority buckets tick first, matching the per-manager priority ordering
+	BucketTickOrder.StableSort([this](const int32 A, const int32 B)
+	{
+		return TickBuckets[A].Priority > TickBuckets[B].Priority;
+	});
+
+	// Greedily merge consecutive worker-thread buckets into waves, a game-thread bucket always starts a new wave
+	TickWaves.Reset();
+	for (const int32 BucketIndex : BucketTickOrder)
+	{
+		const FCapabilityTickBucket& Bucket = TickBuckets[BucketIndex];
+		FCapabilityTickWave* CurrentWave = TickWaves.IsEmpty() ? nullptr : &TickWaves.Last();
+
+		bool bJoinCurrentWave = CurrentWave && CurrentWave->bParallel && Bucket.bTickOnWorkerThread;
+		if (bJoinCurrentWave)
+		{
+			for (const int32 WaveBucketIndex : CurrentWave->BucketIndices)
+			{
+				if (DoBucketsConflict(Bucket, TickBuckets[WaveBucketIndex]))
+				{
+					bJoinCurrentWave = false;
+					break;
+				}
+			}
+		}
+
+		if (!bJoinCurrentWave)
+		{
+			CurrentWave = &TickWaves.AddDefaulted_GetRef();
+			CurrentWave->bParallel = Bucket.bTickOnWorkerThread;
+		}
+		CurrentWave->BucketIndices.Add(BucketIndex);
+	}
+
+	bBucketOrderDirty = false;
+}
+
+bool UCapabilitySchedulerSubsystem::DoBucketsConflict(const FCapabilityTickBucket& A, const FCapabilityTickBucket& B)
+{
+	// Component classes overlap when either is a subclass of the other
+	auto Overlaps = [](const TArray<UClass*>& Writes, const TArray<UClass*>& Others)
+	{
+		for (const UClass* Write : Writes)
+		{
+			for (const UClass* Other : Others)
+			{
+				if (Write && Other && (Write->IsChildOf(Other) || Other->IsChildOf(Write)))
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	};
+
+	return Overlaps(A.WriteComponents, B.WriteComponents)
+		|| Overlaps(A.WriteComponents, B.ReadComponents)
+		|| Overlaps(B.WriteComponents, A.ReadComponents);
+}
+
+void UCapabilitySchedulerSubsystem::SetSchedulerEnabled(bool bEnabled)
+{
+	bSchedulerEnabled = bEnabled;
+
+	// Owning actors pick up pending updates through their own ManualTick again
+	if (!bEnabled)
+	{
+		for (UCapabilityManagerComponent* Manager : PendingActivationUpdates)
+		{
+			if (Manager)
+			{
+				Manager->bQueuedForActivationUpdate = false;
+			}
+		}
+		PendingActivationUpdates.Reset();
+
+		for (UCapabilityManagerComponent* Manager : Managers)
+		{
+			if (Manager)
+			{
+				Manager->bInActivationCheckQueue = false;
+				++Manager->ActivationCheckSerial;
+			}
+		}
+		ActivationCheckQueue.Reset();
+	}
+
+	// Hand ticking back to (or take it from) the owning actors
+	for (UCapabilityManagerComponent* Manager : Managers)
+	{
+		if (Manager)
+		{
+			Manager->SetTickedByScheduler(bEnabled);
+		}
+	}
+
+	if (bEnabled)
+	{
+		ScheduleAllActivationChecks();
+	}
+}
+
+void UCapabilitySchedulerSubsystem::SampleFrameTime(float CapabilityWorkMs)
+{
+	// Game thread time of the previous frame, this includes the engine's per-actor tick dispatch we are trying to avoid
+	const float FrameMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	if (FrameMs <= 0.0f)
+	{
+		return;
+	}
+
+	if (bSchedulerEnabled)
+	{
+		BatchedFrameMs = bHasBatchedSample ? FMath::Lerp(BatchedFrameMs, FrameMs, FrameTimeSmoothing) : FrameMs;
+		BatchedCapabilityWorkMs = bHasBatchedSample ? FMath::Lerp(BatchedCapabilityWorkMs, CapabilityWorkMs, FrameTimeSmoothing) : CapabilityWorkMs;
+		bHasBatchedSample = true;
+	}
+	else
+	{
+		PerActorFrameMs = bHasPerActorSample ? FMath::Lerp(PerActorFrameMs, FrameMs, FrameTimeSmoothing) : FrameMs;
+		bHasPerActorSample = true;
+	}
+
+	SET_FLOAT_STAT(STAT_CapabilityScheduler_FrameTimeSaved, GetEstimatedFrameTimeSavedMs());
+}
+
+float UCapabilitySchedulerSubsystem::GetEstimatedFrameTimeSavedMs() const
+{
+	return (bHasBatchedSample && bHasPerActorSample) ? PerActorFrameMs - BatchedFrameMs : 0.0f;
+}
+
+void UCapabilitySchedulerSubsystem::LogReport() const
+{
+	int32 NumReleasedActorTicks = 0;
+	int32 NumActiveCapabilities = 0;
+	for (const UCapabilityManagerComponent* Manager : Managers)
+	{
+		if (Manager)
+		{
+			NumReleasedActorTicks += Manager->bReleasedOwnerTick ? 1 : 0;
+			NumActiveCapabilities += Manager->ActiveCapabilities.Num();
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Capability scheduler (%s): %s, %d managers, %d active capabilities in %d classes, %d actor tick functions released"),
+		*GetWorld()->GetName(), bSchedulerEnabled ? TEXT("batched") : TEXT("per-actor"),
+		NumRegisteredManagers, NumActiveCapabilities, TickBuckets.Num(), NumReleasedActorTicks);
+
+	UE_LOG(LogTemp, Log, TEXT("  Batched: %s game thread ms/frame, %.3f ms/frame in capability work"),
+		bHasBatchedSample ? *FString::Printf(TEXT("%.3f"), BatchedFrameMs) : TEXT("n/a"), BatchedCapabilityWorkMs);
+	UE_LOG(LogTemp, Log, TEXT("  Per-actor: %s game thread ms/frame"),
+		bHasPerActorSample ? *FString::Printf(TEXT("%.3f"), PerActorFrameMs) : TEXT("n/a"));
+
+	for (const FCapabilityTickBucket& Bucket : TickBuckets)
+	{
+		if (Bucket.DeferredFrames > 0)
+		{
+			UE_LOG(LogTemp, Log, TEXT("  Tick budget: %s (priority %d) deferred for %d frames%s"),
+				*GetNameSafe(Bucket.CapabilityClass), Bucket.Priority, Bucket.DeferredFrames, Bucket.bStarved ? TEXT(" (starved)") : TEXT(""));
+		}
+	}
+
+	if (bHasBatchedSample && bHasPerActorSample)
+	{
+		UE_LOG(LogTemp, Log, TEXT("  Estimated saving: %.3f ms/frame"), GetEstimatedFrameTimeSavedMs());
+	}
+	else
+	{
+		UE_LOG(LogTemp, Log, TEXT("  Toggle ECS.Scheduler.Enabled to sample both modes before comparing."));
+	}
+}
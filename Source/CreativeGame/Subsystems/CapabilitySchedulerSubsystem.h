@@ -0,0 +1,278 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "../Capabilities/CapabilityFixedTimestep.h"
+
+// Forward declarations instead of full includes in header
+class UBaseCapability;
+class UCapabilityManagerComponent;
+class UCapabilitySchedulerSubsystem;
+
+#include "CapabilitySchedulerSubsystem.generated.h"
+
+/**
+ * The single tick function owned by the capability scheduler.
+ * Runs in TG_PrePhysics so capabilities keep ticking where the owning actors used to tick them.
+ */
+USTRUCT()
+struct FCapabilitySchedulerTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UCapabilitySchedulerSubsystem* Scheduler = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+	virtual FName DiagnosticContext(bool bDetailed) override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FCapabilitySchedulerTickFunction> : public TStructOpsTypeTraitsBase2<FCapabilitySchedulerTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Active capabilities of a single class and priority, ticked back to back by the scheduler.
+ * Capabilities remember their slot so activation changes are O(1) swap-removes.
+ */
+struct FCapabilityTickBucket
+{
+	UClass* CapabilityClass = nullptr;
+
+	// Priority of every capability in the bucket, used to order buckets (higher priority ticks first)
+	int32 Priority = 0;
+
+	TArray<UBaseCapability*> Capabilities;
+
+	// Set when slots were cleared while the bucket was being iterated
+	bool bNeedsCompaction = false;
+
+	// Class declares TickLODLevels, copied from its default object
+	bool bUsesTickLOD = false;
+
+	// Worker-thread declaration of the class, copied from its default object
+	bool bTickOnWorkerThread = false;
+	TArray<UClass*> ReadComponents;
+	TArray<UClass*> WriteComponents;
+
+	// Tick budget - time and frames the bucket has been pushed back by higher priority classes
+	float DeferredDeltaTime = 0.0f;
+	int32 DeferredFrames = 0;
+	bool bStarved = false;
+};
+
+/**
+ * A run of buckets ticked together. Parallel waves only contain worker-thread buckets whose
+ * declared component access doesn't conflict, and are followed by a sync point on the game thread.
+ */
+struct FCapabilityTickWave
+{
+	TArray<int32> BucketIndices;
+	bool bParallel = false;
+};
+
+/**
+ * Capabilities of one class waiting for their activation predicate to be evaluated.
+ */
+struct FCapabilityPredicateBatch
+{
+	TArray<TWeakObjectPtr<UBaseCapability>> Pending;
+	bool bQueued = false;
+};
+
+/**
+ * A manager's next periodic activation check. Entries of managers that unregistered or were rescheduled
+ * are left in the queue and skipped when popped, their serial no longer matches the manager's.
+ */
+struct FCapabilityActivationCheck
+{
+	float DueTime = 0.0f;
+	TWeakObjectPtr<UCapabilityManagerComponent> Manager;
+	uint32 Serial = 0;
+
+	bool operator<(const FCapabilityActivationCheck& Other) const { return DueTime < Other.DueTime; }
+};
+
+/**
+ * World-level scheduler that ticks every registered UCapabilityManagerComponent from a single tick function.
+ * Managers register themselves at BeginPlay and unregister at EndPlay, so owning actors no longer need their own Tick.
+ *
+ * Each frame is split into three phases:
+ * - Periodic activation checks that are due, then queued activation updates
+ * - TickCapability for every active capability, grouped by capability class to keep caches warm
+ * - Activation updates queued while capabilities were ticking
+ *
+ * Managers only enter the activation queue when something changed (a state update request, a component field
+ * or owner tag an event-driven capability depends on), so idle managers cost nothing outside the tick itself.
+ * Periodic checks of managers owning polled capabilities come from a queue ordered by due time. Each manager
+ * starts at its own phase within the update period, and ECS.Capabilities.ActivationChecksPerFrame caps how many
+ * run per frame, so actors spawned together don't all re-check activation in the same frame.
+ *
+ * Capabilities that opt in with bTickOnWorkerThread are ticked with ParallelFor. Consecutive worker-thread classes
+ * whose declared Read/WriteComponents don't overlap share one parallel wave, and structural changes made from
+ * worker threads are applied on the game thread at the sync point after each wave.
+ *
+ * Capabilities with an activation predicate are queued per class instead of being checked one by one. Each batch is
+ * evaluated by the class's compiled predicate program in a single pass at the end of every activation queue pass.
+ *
+ * Lightweight capabilities (ULightweightCapability) are ticked per manager on the game thread after every bucket.
+ *
+ * Classes with TickLODLevels tick every N frames, or not at all, far from every player viewpoint, and get the
+ * DeltaTime accumulated since their last tick when they do run.
+ *
+ * With ECS.FixedStep.Enabled the capability phase runs zero or more times per frame with a fixed DeltaTime, and
+ * activation updates are processed after every step. GetInterpolationAlpha tells rendering how far into the next step the frame is.
+ *
+ * With ECS.Scheduler.TickBudgetMs the buckets tick in priority order until the budget is used up. Classes that didn't
+ * fit roll over to the next frame and tick with the DeltaTime accumulated meanwhile. Classes deferred for more than
+ * ECS.Scheduler.StarvationFrames frames are logged and counted as starved. Lightweight capabilities are not budgeted.
+ * Instances whose priority was changed with SetPriority move to the bucket of their class and new priority.
+ *
+ * Set ECS.Scheduler.Enabled 0 to fall back to per-actor ticking and ECS.Scheduler.Report to compare frame times.
+ */
+UCLASS()
+class CREATIVEGAME_API UCapabilitySchedulerSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	// Manager registration - called by UCapabilityManagerComponent at BeginPlay/EndPlay
+	void RegisterManager(UCapabilityManagerComponent* Manager);
+	void UnregisterManager(UCapabilityManagerComponent* Manager);
+
+	// Active capability tracking - called by UCapabilityManagerComponent when activation changes
+	void AddToTickBucket(UBaseCapability* Capability);
+	void RemoveFromTickBucket(UBaseCapability* Capability);
+
+	// Managers with active lightweight capabilities - ticked on the game thread after the capability buckets
+	void AddLightweightTickManager(UCapabilityManagerComponent* Manager);
+	void RemoveLightweightTickManager(UCapabilityManagerComponent* Manager);
+
+	// Thread-safe - a manager recorded commands from a worker thread, they're applied at the next sync point
+	void EnqueueWorkerStateUpdateRequest(UCapabilityManagerComponent* Manager);
+
+	// Queue a manager with pending activation changes, processed before and after capabilities tick
+	void QueueActivationUpdate(UCapabilityManagerComponent* Manager);
+
+	// Queue a capability whose activation predicate should be re-evaluated with the rest of its class
+	void QueuePredicateEvaluation(UBaseCapability* Capability);
+
+	// Start periodic activation checks for a manager that now owns polled capabilities
+	void ScheduleActivationCheck(UCapabilityManagerComponent* Manager);
+
+	// True while capability buckets are being ticked
+	bool IsTickingCapabilities() const { return bTickingBuckets; }
+
+	// Whether the scheduler is currently responsible for ticking registered managers
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	bool IsSchedulerEnabled() const { return bSchedulerEnabled; }
+
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	int32 GetNumRegisteredManagers() const { return NumRegisteredManagers; }
+
+	// Average game thread frame time saved by batch ticking, compared with per-actor ticking (needs samples of both modes)
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	float GetEstimatedFrameTimeSavedMs() const;
+
+	// Fraction of a fixed step left unsimulated this frame, 1 when ECS.FixedStep.Enabled is off
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	float GetInterpolationAlpha() const { return InterpolationAlpha; }
+
+	// Capability classes the tick budget has deferred for more than ECS.Scheduler.StarvationFrames frames
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	int32 GetNumStarvedCapabilityClasses() const { return NumStarvedBuckets; }
+
+	// Log a comparison of batched and per-actor ticking for this world
+	void LogReport() const;
+
+	// Main scheduler update, driven by SchedulerTickFunction
+	void TickScheduler(float DeltaTime);
+
+private:
+	void TickCapabilityBuckets(float DeltaTime);
+	int32 TickSerialBucket(int32 BucketIndex, float DeltaTime);
+	int32 TickParallelWave(const FCapabilityTickWave& Wave, float DeltaTime);
+	bool IsTickBudgetExhausted() const;
+	float TakeDeferredDeltaTime(int32 BucketIndex, float DeltaTime);
+	void DeferBucket(int32 BucketIndex, float DeltaTime);
+	void FlushWorkerRequests();
+	void ProcessActivationQueue();
+	void EvaluateActivationPredicates();
+	void RunDueActivationChecks(float CurrentTime);
+	void PushActivationCheck(UCapabilityManagerComponent* Manager, float DueTime);
+	void ScheduleAllActivationChecks();
+	void CompactTickBuckets();
+	void TickLightweightCapabilities(float DeltaTime);
+	void RebuildTickWaves();
+	static bool DoBucketsConflict(const FCapabilityTickBucket& A, const FCapabilityTickBucket& B);
+	void SetSchedulerEnabled(bool bEnabled);
+	void SampleFrameTime(float CapabilityWorkMs);
+
+	FCapabilitySchedulerTickFunction SchedulerTickFunction;
+
+	// Registered managers, only iterated when the scheduler is toggled or for reports
+	TArray<UCapabilityManagerComponent*> Managers;
+	int32 NumRegisteredManagers = 0;
+
+	// Min-heap of periodic activation checks by due time
+	TArray<FCapabilityActivationCheck> ActivationCheckQueue;
+	bool bActivationPollingForced = false;
+
+	// Managers with pending activation updates, deduplicated through the manager's queued flag
+	TArray<UCapabilityManagerComponent*> PendingActivationUpdates;
+
+	// Buckets are never removed so capability bucket indices stay stable, BucketTickOrder holds the sorted order
+	TArray<FCapabilityTickBucket> TickBuckets;
+	TMap<TPair<UClass*, int32>, int32> BucketIndexByClassAndPriority;
+	TArray<int32> BucketTickOrder;
+	TArray<FCapabilityTickWave> TickWaves;
+	bool bTickingBuckets = false;
+	bool bBucketOrderDirty = false;
+	bool bAnyBucketNeedsCompaction = false;
+
+	// Managers with active lightweight capabilities, slots are cleared while ticking and compacted afterwards
+	TArray<UCapabilityManagerComponent*> LightweightTickManagers;
+	bool bLightweightTickManagersNeedCompaction = false;
+
+	// Predicate batches by capability type id, and the ones with pending capabilities
+	TArray<FCapabilityPredicateBatch> PredicateBatches;
+	TArray<int32> QueuedPredicateBatches;
+	TArray<UBaseCapability*> PredicateWork;
+	TArray<uint8> PredicateResults;
+
+	// Scratch lists reused by every parallel wave
+	TArray<UBaseCapability*> ParallelWork;
+	TArray<UBaseCapability*> GameThreadWork;
+
+	TQueue<UCapabilityManagerComponent*, EQueueMode::Mpsc> WorkerStateUpdateRequests;
+
+	bool bSchedulerEnabled = true;
+
+	// Global fixed timestep, only advanced while ECS.FixedStep.Enabled is set
+	FCapabilityFixedTimestep FixedTimestep;
+	float InterpolationAlpha = 1.0f;
+
+	// End of this frame's tick budget in cycles, 0 when ECS.Scheduler.TickBudgetMs is off
+	uint64 TickBudgetEndCycles = 0;
+	int32 NumStarvedBuckets = 0;
+
+	// Moving averages used to report the saving compared with per-actor ticking
+	float BatchedFrameMs = 0.0f;
+	float PerActorFrameMs = 0.0f;
+	float BatchedCapabilityWorkMs = 0.0f;
+	bool bHasBatchedSample = false;
+	bool bHasPerActorSample = false;
+};
@@ -0,0 +1,181 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapabilityTimerWheelSubsystem.h"
+#include "../Capabilities/BaseCapability.h"
+#include "../Capabilities/CapabilityStats.h"
+#include "../Components/CapabilityManagerComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Timer Wheel Advance"), STAT_Capabilities_TimerWheelAdvance, STATGROUP_Capabilities);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Timer Wheel Wakes"), STAT_Capabilities_TimerWheelWakes, STATGROUP_Capabilities);
+
+static TAutoConsoleVariable<float> CVarCapabilitiesSleepResolution(
+	TEXT("ECS.Capabilities.SleepResolution"),
+	0.01f,
+	TEXT("Granularity in seconds of the timing wheel waking sleeping capabilities. Applied when a world is created.\n")
+	TEXT("Capabilities wake in the first frame at or after the end of the tick containing their wake time."),
+	ECVF_Default);
+
+UCapabilityTimerWheelSubsystem* UCapabilityTimerWheelSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UCapabilityTimerWheelSubsystem>() : nullptr;
+}
+
+bool UCapabilityTimerWheelSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// Capabilities only sleep in worlds that tick them
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCapabilityTimerWheelSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Resolution = FMath::Max(CVarCapabilitiesSleepResolution.GetValueOnGameThread(), 0.001f);
+}
+
+void UCapabilityTimerWheelSubsystem::Deinitialize()
+{
+	for (int32 Level = 0; Level < NumLevels; ++Level)
+	{
+		for (TArray<FCapabilityTimer>& Slot : Slots[Level])
+		{
+			Slot.Empty();
+		}
+	}
+	Overflow.Empty();
+	NumTimers = 0;
+
+	Super::Deinitialize();
+}
+
+TStatId UCapabilityTimerWheelSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCapabilityTimerWheelSubsystem, STATGROUP_Tickables);
+}
+
+uint64 UCapabilityTimerWheelSubsystem::ToTick(float Time) const
+{
+	return Time > 0.0f ? static_cast<uint64>(FMath::CeilToDouble(static_cast<double>(Time) / Resolution)) : 0;
+}
+
+void UCapabilityTimerWheelSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Only ticks that have fully elapsed are processed, wake times round up with ToTick so nothing fires early
+	const uint64 CurrentTick = static_cast<uint64>(FMath::FloorToDouble(FMath::Max(static_cast<double>(GetWorld()->GetTimeSeconds()), 0.0) / Resolution));
+	if (NumTimers == 0)
+	{
+		// Nothing to visit, just keep up with the clock
+		NextTick = FMath::Max(NextTick, CurrentTick + 1);
+		return;
+	}
+
+	Advance(CurrentTick);
+}
+
+void UCapabilityTimerWheelSubsystem::ScheduleWake(UBaseCapability* Capability, float WakeTime)
+{
+	if (!Capability)
+	{
+		return;
+	}
+
+	FCapabilityTimer Timer;
+	Timer.Capability = Capability;
+	Timer.Serial = Capability->SleepSerial;
+
+	// Never schedule into a slot that was already processed
+	Timer.WakeTick = FMath::Max(ToTick(WakeTime), NextTick);
+
+	Insert(Timer, NextTick);
+	++NumTimers;
+}
+
+void UCapabilityTimerWheelSubsystem::Insert(const FCapabilityTimer& Timer, uint64 BaseTick)
+{
+	// The level is the highest slot group in which the wake tick still differs from the base tick
+	const uint64 Difference = Timer.WakeTick ^ BaseTick;
+	for (int32 Level = 0; Level < NumLevels; ++Level)
+	{
+		if ((Difference >> (SlotBits * (Level + 1))) == 0)
+		{
+			Slots[Level][(Timer.WakeTick >> (SlotBits * Level)) & (NumSlots - 1)].Add(Timer);
+			return;
+		}
+	}
+
+	Overflow.Add(Timer);
+}
+
+void UCapabilityTimerWheelSubsystem::Advance(uint64 ToTick)
+{
+	SCOPE_CYCLE_COUNTER(STAT_Capabilities_TimerWheelAdvance);
+
+	while (NextTick <= ToTick && NumTimers > 0)
+	{
+		// Moved on before firing, so capabilities put back to sleep while waking never land in this tick's slot
+		const uint64 Tick = NextTick++;
+
+		// Top level wrapped - anything in the overflow list may now fit in the wheel
+		if ((Tick & ((uint64(1) << (SlotBits * NumLevels)) - 1)) == 0)
+		{
+			Cascade(Overflow, Tick);
+		}
+
+		// Move the slots this tick reached one level down, higher levels first as they can feed lower ones
+		for (int32 Level = NumLevels - 1; Level > 0; --Level)
+		{
+			if ((Tick & ((uint64(1) << (SlotBits * Level)) - 1)) == 0)
+			{
+				Cascade(Slots[Level][(Tick >> (SlotBits * Level)) & (NumSlots - 1)], Tick);
+			}
+		}
+
+		Fire(Slots[0][Tick & (NumSlots - 1)]);
+	}
+
+	// Caught up or out of timers, the remaining ticks have nothing in them
+	NextTick = FMath::Max(NextTick, ToTick + 1);
+}
+
+void UCapabilityTimerWheelSubsystem::Cascade(TArray<FCapabilityTimer>& Timers, uint64 BaseTick)
+{
+	if (Timers.IsEmpty())
+	{
+		return;
+	}
+
+	TArray<FCapabilityTimer> Moving = MoveTemp(Timers);
+	Timers.Reset();
+	for (const FCapabilityTimer& Timer : Moving)
+	{
+		Insert(Timer, BaseTick);
+	}
+}
+
+void UCapabilityTimerWheelSubsystem::Fire(TArray<FCapabilityTimer>& Timers)
+{
+	if (Timers.IsEmpty())
+	{
+		return;
+	}
+
+	// Waking can schedule new timers, which always land in later slots
+	TArray<FCapabilityTimer> Due = MoveTemp(Timers);
+	Timers.Reset();
+	NumTimers -= Due.Num();
+
+	for (const FCapabilityTimer& Timer : Due)
+	{
+		UBaseCapability* Capability = Timer.Capability.Get();
+		if (Capability && Capability->SleepSerial == Timer.Serial && Capability->OwningManager)
+		{
+			INC_DWORD_STAT(STAT_Capabilities_TimerWheelWakes);
+			Capability->OwningManager->WakeCapability(Capability);
+		}
+	}
+}
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+class UBaseCapability;
+
+#include "CapabilityTimerWheelSubsystem.generated.h"
+
+/**
+ * A capability waiting in the timing wheel. Cancelled timers stay where they are and are skipped when they fire,
+ * their serial no longer matches the capability's.
+ */
+struct FCapabilityTimer
+{
+	TWeakObjectPtr<UBaseCapability> Capability;
+	uint64 WakeTick = 0;
+	uint32 Serial = 0;
+};
+
+/**
+ * Hierarchical timing wheel waking sleeping capabilities, see UCapabilityManagerComponent::SleepCapabilityFor.
+ *
+ * Time is split into ticks of ECS.Capabilities.SleepResolution seconds. Each level has 64 slots, a timer goes to the
+ * level of the highest 6-bit group in which its wake tick differs from the current tick and is moved down a level
+ * whenever the current tick reaches its slot, so scheduling, cancelling and waking are all O(1) and a frame only
+ * visits the slots of the ticks that passed. Timers beyond the top level wait in an overflow list.
+ */
+UCLASS()
+class CREATIVEGAME_API UCapabilityTimerWheelSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Convenience accessor for the subsystem of a world context object's world
+	static UCapabilityTimerWheelSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Wake Capability through its manager once the world time reaches WakeTime, cancelled by changing its sleep serial
+	void ScheduleWake(UBaseCapability* Capability, float WakeTime);
+
+	UFUNCTION(BlueprintPure, Category = "Capabilities")
+	int32 GetNumScheduledTimers() const { return NumTimers; }
+
+private:
+	static constexpr int32 SlotBits = 6;
+	static constexpr int32 NumSlots = 1 << SlotBits;
+	static constexpr int32 NumLevels = 4;
+
+	void Advance(uint64 ToTick);
+	void Insert(const FCapabilityTimer& Timer, uint64 BaseTick);
+	void Cascade(TArray<FCapabilityTimer>& Timers, uint64 BaseTick);
+	void Fire(TArray<FCapabilityTimer>& Timers);
+	uint64 ToTick(float Time) const;
+
+	float Resolution = 0.01f;
+
+	// Next tick whose slot hasn't been processed yet
+	uint64 NextTick = 0;
+
+	TArray<FCapabilityTimer> Slots[NumLevels][NumSlots];
+	TArray<FCapabilityTimer> Overflow;
+	int32 NumTimers = 0;
+};
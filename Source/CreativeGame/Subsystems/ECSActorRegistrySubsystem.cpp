@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ECSActorRegistrySubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+DECLARE_STATS_GROUP(TEXT("ECS Registry"), STATGROUP_ECSRegistry, STATCAT_Advanced);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Registered Actors"), STAT_ECSRegistry_NumActors, STATGROUP_ECSRegistry);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Registered Classes"), STAT_ECSRegistry_NumClasses, STATGROUP_ECSRegistry);
+
+UECSActorRegistrySubsystem* UECSActorRegistrySubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UECSActorRegistrySubsystem>() : nullptr;
+}
+
+bool UECSActorRegistrySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// ECS actors only register once they begin play
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UECSActorRegistrySubsystem::Deinitialize()
+{
+	DEC_DWORD_STAT_BY(STAT_ECSRegistry_NumActors, SlotByActor.Num());
+	DEC_DWORD_STAT_BY(STAT_ECSRegistry_NumClasses, ClassLists.Num());
+
+	ClassLists.Reset();
+	ClassListIndexByClass.Reset();
+	SlotByActor.Reset();
+	MatchingListsByFilter.Reset();
+
+	Super::Deinitialize();
+}
+
+void UECSActorRegistrySubsystem::RegisterActor(AActor* Actor)
+{
+	if (!IsValid(Actor) || SlotByActor.Contains(Actor))
+	{
+		return;
+	}
+
+	ensureMsgf(VisitDepth == 0, TEXT("%s registered while the ECS actor registry is being visited"), *Actor->GetName());
+
+	UClass* ActorClass = Actor->GetClass();
+	int32 ListIndex = INDEX_NONE;
+	if (const int32* ExistingIndex = ClassListIndexByClass.Find(ActorClass))
+	{
+		ListIndex = *ExistingIndex;
+	}
+	else
+	{
+		// Lists are never removed, so list indices cached per filter stay valid until a new class shows up
+		ListIndex = ClassLists.AddDefaulted();
+		ClassLists[ListIndex].ActorClass = ActorClass;
+		ClassListIndexByClass.Add(ActorClass, ListIndex);
+		MatchingListsByFilter.Reset();
+		INC_DWORD_STAT(STAT_ECSRegistry_NumClasses);
+	}
+
+	SlotByActor.Add(Actor, ClassLists[ListIndex].Actors.Add(Actor));
+	++ChangeSerial;
+	INC_DWORD_STAT(STAT_ECSRegistry_NumActors);
+}
+
+void UECSActorRegistrySubsystem::UnregisterActor(AActor* Actor)
+{
+	int32 Slot = INDEX_NONE;
+	if (!SlotByActor.RemoveAndCopyValue(Actor, Slot))
+	{
+		return;
+	}
+
+	ensureMsgf(VisitDepth == 0, TEXT("%s unregistered while the ECS actor registry is being visited"), *Actor->GetName());
+
+	DEC_DWORD_STAT(STAT_ECSRegistry_NumActors);
+	++ChangeSerial;
+
+	TArray<AActor*>& Actors = ClassLists[ClassListIndexByClass.FindChecked(Actor->GetClass())].Actors;
+	Actors.RemoveAtSwap(Slot, 1, EAllowShrinking::No);
+	if (Actors.IsValidIndex(Slot))
+	{
+		// Fix up the slot of the actor that was swapped into the freed one
+		SlotByActor.FindChecked(Actors[Slot]) = Slot;
+	}
+}
+
+const TArray<int32>& UECSActorRegistrySubsystem::GetMatchingLists(const UClass* ClassFilter) const
+{
+	if (const TArray<int32>* Cached = MatchingListsByFilter.Find(ClassFilter))
+	{
+		return *Cached;
+	}
+
+	TArray<int32>& Matching = MatchingListsByFilter.Add(ClassFilter);
+	for (int32 ListIndex = 0; ListIndex < ClassLists.Num(); ++ListIndex)
+	{
+		if (!ClassFilter || ClassLists[ListIndex].ActorClass->IsChildOf(ClassFilter))
+		{
+			Matching.Add(ListIndex);
+		}
+	}
+	return Matching;
+}
+
+void UECSActorRegistrySubsystem::ForEachActorOfClass(const UClass* ClassFilter, TFunctionRef<void(AActor*)> Visitor) const
+{
+	// A visitor querying a new filter can reallocate MatchingListsByFilter, keep our own copy of the indices
+	const TArray<int32, TInlineAllocator<16>> MatchingLists(GetMatchingLists(ClassFilter));
+
+	++VisitDepth;
+	for (const int32 ListIndex : MatchingLists)
+	{
+		// Indexed so a registration made by the visitor despite the ensure can't invalidate the iteration
+		for (int32 ActorIndex = 0; ActorIndex < ClassLists[ListIndex].Actors.Num(); ++ActorIndex)
+		{
+			Visitor(ClassLists[ListIndex].Actors[ActorIndex]);
+		}
+	}
+	--VisitDepth;
+}
+
+TConstArrayView<AActor*> UECSActorRegistrySubsystem::GetActorsOfExactClass(const UClass* ActorClass) const
+{
+	const int32* ListIndex = ClassListIndexByClass.Find(ActorClass);
+	return ListIndex ? TConstArrayView<AActor*>(ClassLists[*ListIndex].Actors) : TConstArrayView<AActor*>();
+}
+
+int32 UECSActorRegistrySubsystem::GetNumActorsOfClass(TSubclassOf<AActor> ActorClass) const
+{
+	int32 NumActors = 0;
+	for (const int32 ListIndex : GetMatchingLists(ActorClass))
+	{
+		NumActors += ClassLists[ListIndex].Actors.Num();
+	}
+	return NumActors;
+}
+
+void UECSActorRegistrySubsystem::GetActorsOfClass(TSubclassOf<AActor> ActorClass, TArray<AActor*>& OutActors) const
+{
+	for (const int32 ListIndex : GetMatchingLists(ActorClass))
+	{
+		OutActors.Append(ClassLists[ListIndex].Actors);
+	}
+}
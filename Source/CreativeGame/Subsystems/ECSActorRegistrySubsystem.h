@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Templates/Function.h"
+
+#include "ECSActorRegistrySubsystem.generated.h"
+
+/**
+ * Live ECS actors of one exact class, packed densely so iteration is a straight array walk.
+ */
+struct FECSActorClassList
+{
+	UClass* ActorClass = nullptr;
+	TArray<AActor*> Actors;
+};
+
+/**
+ * Registry of every ECS actor, pawn and character in the world, grouped by exact class.
+ * Actors register at BeginPlay and unregister at EndPlay with an O(1) swap-remove, so class-filtered iteration
+ * never walks the world's actor list and never allocates, unlike UGameplayStatics::GetAllActorsOfClass.
+ *
+ * A filter visits the lists of every registered class that is a child of it. The matching lists are cached
+ * per filter and only rebuilt when an actor of a new class registers.
+ */
+UCLASS()
+class CREATIVEGAME_API UECSActorRegistrySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Convenience accessor for the subsystem of a world context object's world
+	static UECSActorRegistrySubsystem* Get(const UObject* WorldContextObject);
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+
+	// Registration - called by the ECS base classes at BeginPlay/EndPlay
+	void RegisterActor(AActor* Actor);
+	void UnregisterActor(AActor* Actor);
+
+	// Visit every registered actor of ClassFilter or a subclass. The visitor may run other registry queries,
+	// but must not register or unregister actors - that ensures and can skip or repeat actors of the visited lists.
+	void ForEachActorOfClass(const UClass* ClassFilter, TFunctionRef<void(AActor*)> Visitor) const;
+
+	template<typename T>
+	void ForEachActor(TFunctionRef<void(T*)> Visitor) const
+	{
+		ForEachActorOfClass(T::StaticClass(), [&Visitor](AActor* Actor)
+		{
+			Visitor(static_cast<T*>(Actor));
+		});
+	}
+
+	// Registered actors of exactly this class, empty for unregistered classes
+	TConstArrayView<AActor*> GetActorsOfExactClass(const UClass* ActorClass) const;
+
+	UFUNCTION(BlueprintPure, Category = "ECS")
+	int32 GetNumRegisteredActors() const { return SlotByActor.Num(); }
+
+	// Changes whenever an actor registers or unregisters, for caches built from the registry
+	uint32 GetChangeSerial() const { return ChangeSerial; }
+
+	// Number of registered actors of ActorClass or a subclass, without visiting them
+	UFUNCTION(BlueprintPure, Category = "ECS")
+	int32 GetNumActorsOfClass(TSubclassOf<AActor> ActorClass) const;
+
+	// Blueprint version of ForEachActorOfClass, appends to OutActors instead of allocating a new array
+	UFUNCTION(BlueprintCallable, Category = "ECS")
+	void GetActorsOfClass(TSubclassOf<AActor> ActorClass, TArray<AActor*>& OutActors) const;
+
+private:
+	const TArray<int32>& GetMatchingLists(const UClass* ClassFilter) const;
+
+	TArray<FECSActorClassList> ClassLists;
+	TMap<const UClass*, int32> ClassListIndexByClass;
+
+	// Index of each registered actor in its class list
+	TMap<const AActor*, int32> SlotByActor;
+
+	uint32 ChangeSerial = 0;
+
+	// Non-zero while ForEachActorOfClass is calling its visitor, registration changes are not allowed then
+	mutable int32 VisitDepth = 0;
+
+	// Class lists matching each filter queried so far, reset when a new class list is added
+	mutable TMap<const UClass*, TArray<int32>> MatchingListsByFilter;
+};
@@ -0,0 +1,401 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ECSArchetypeSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UnrealType.h"
+
+static TAutoConsoleVariable<int32> CVarECSArchetypeChunkBytes(
+	TEXT("ECS.Archetypes.ChunkBytes"),
+	16 * 1024,
+	TEXT("Target size in bytes of an archetype chunk. Smaller chunks waste less memory on rare archetypes,\n")
+	TEXT("larger ones mean fewer chunk switches when iterating. Applies to archetypes created afterwards."),
+	ECVF_Default);
+
+void* FECSChunkView::GetFragmentColumn(const UScriptStruct* FragmentType) const
+{
+	const int32 Column = Archetype ? Archetype->FindColumn(FragmentType) : INDEX_NONE;
+	return Column != INDEX_NONE ? Archetype->GetFragmentMemory(ChunkIndex, 0, Column) : nullptr;
+}
+
+UECSArchetypeSubsystem* UECSArchetypeSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UECSArchetypeSubsystem>() : nullptr;
+}
+
+bool UECSArchetypeSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// Components only register their fragments once they begin play
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UECSArchetypeSubsystem::Deinitialize()
+{
+	for (FECSArchetype& Archetype : Archetypes)
+	{
+		for (int32 ChunkIndex = 0; ChunkIndex < Archetype.Chunks.Num(); ++ChunkIndex)
+		{
+			for (int32 Column = 0; Column < Archetype.FragmentTypes.Num(); ++Column)
+			{
+				Archetype.FragmentTypes[Column]->DestroyStruct(Archetype.GetFragmentMemory(ChunkIndex, 0, Column), Archetype.Chunks[ChunkIndex].NumRows);
+			}
+			FMemory::Free(Archetype.Chunks[ChunkIndex].Memory);
+		}
+	}
+
+	Archetypes.Reset();
+	Entities.Reset();
+	FreeEntityIndices.Reset();
+	EntityIndexByOwner.Reset();
+	ExtraFragmentRefs.Reset();
+
+	Super::Deinitialize();
+}
+
+void UECSArchetypeSubsystem::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	Super::AddReferencedObjects(InThis, Collector);
+
+	// Fragments are meant to be plain data, but keep any object references they do hold alive
+	UECSArchetypeSubsystem* This = CastChecked<UECSArchetypeSubsystem>(InThis);
+	for (FECSArchetype& Archetype : This->Archetypes)
+	{
+		for (int32 Column = 0; Column < Archetype.FragmentTypes.Num(); ++Column)
+		{
+			const UScriptStruct* FragmentType = Archetype.FragmentTypes[Column];
+			if (!FragmentType->RefLink)
+			{
+				continue;
+			}
+
+			for (int32 ChunkIndex = 0; ChunkIndex < Archetype.Chunks.Num(); ++ChunkIndex)
+			{
+				for (int32 Row = 0; Row < Archetype.Chunks[ChunkIndex].NumRows; ++Row)
+				{
+					Collector.AddPropertyReferencesWithStructARO(FragmentType, Archetype.GetFragmentMemory(ChunkIndex, Row, Column), This);
+				}
+			}
+		}
+	}
+}
+
+FECSEntityHandle UECSArchetypeSubsystem::AddFragment(AActor* Owner, const UScriptStruct* FragmentType)
+{
+	if (!IsValid(Owner) || !FragmentType)
+	{
+		return FECSEntityHandle();
+	}
+
+	if (!ensureMsgf(IterationDepth == 0, TEXT("Adding fragment %s while iterating archetype chunks"), *FragmentType->GetName()))
+	{
+		return FECSEntityHandle();
+	}
+
+	int32 EntityIndex = INDEX_NONE;
+	if (const int32* ExistingIndex = EntityIndexByOwner.Find(Owner))
+	{
+		EntityIndex = *ExistingIndex;
+		const FEntityRecord& Record = Entities[EntityIndex];
+		if (Archetypes[Record.ArchetypeIndex].FindColumn(FragmentType) == INDEX_NONE)
+		{
+			TArray<const UScriptStruct*> FragmentTypes = Archetypes[Record.ArchetypeIndex].FragmentTypes;
+			FragmentTypes.Add(FragmentType);
+			MoveEntity(EntityIndex, FindOrAddArchetype(MoveTemp(FragmentTypes)));
+		}
+		else
+		{
+			// Another component of the owner already added this type - share its fragment until both removed it
+			++ExtraFragmentRefs.FindOrAdd(TPair<int32, const UScriptStruct*>(EntityIndex, FragmentType));
+		}
+	}
+	else
+	{
+		EntityIndex = FreeEntityIndices.IsEmpty() ? Entities.AddDefaulted() : FreeEntityIndices.Pop(EAllowShrinking::No);
+		Entities[EntityIndex].Owner = Owner;
+		EntityIndexByOwner.Add(Owner, EntityIndex);
+		AddRow(EntityIndex, FindOrAddArchetype({ FragmentType }));
+
+		// AddRow only reserves the row, MoveEntity initializes added fragments itself
+		const FEntityRecord& Record = Entities[EntityIndex];
+		FragmentType->InitializeStruct(Archetypes[Record.ArchetypeIndex].GetFragmentMemory(Record.ChunkIndex, Record.Row, 0));
+	}
+
+	FECSEntityHandle Handle;
+	Handle.Index = EntityIndex;
+	Handle.Serial = Entities[EntityIndex].Serial;
+	return Handle;
+}
+
+void UECSArchetypeSubsystem::RemoveFragment(FECSEntityHandle Entity, const UScriptStruct* FragmentType)
+{
+	if (!FindRecord(Entity))
+	{
+		return;
+	}
+
+	if (!ensureMsgf(IterationDepth == 0, TEXT("Removing fragment %s while iterating archetype chunks"), *GetNameSafe(FragmentType)))
+	{
+		return;
+	}
+
+	const TPair<int32, const UScriptStruct*> RefKey(Entity.Index, FragmentType);
+	if (int32* ExtraRefs = ExtraFragmentRefs.Find(RefKey))
+	{
+		if (--*ExtraRefs == 0)
+		{
+			ExtraFragmentRefs.Remove(RefKey);
+		}
+		return;
+	}
+
+	const FEntityRecord& Record = Entities[Entity.Index];
+	TArray<const UScriptStruct*> FragmentTypes = Archetypes[Record.ArchetypeIndex].FragmentTypes;
+	if (FragmentTypes.Remove(FragmentType) == 0)
+	{
+		return;
+	}
+
+	if (!FragmentTypes.IsEmpty())
+	{
+		MoveEntity(Entity.Index, FindOrAddArchetype(MoveTemp(FragmentTypes)));
+		return;
+	}
+
+	// Last fragment gone - free the entity, bumping the serial invalidates outstanding handles
+	RemoveRow(Entity.Index, true);
+	FEntityRecord& FreedRecord = Entities[Entity.Index];
+	EntityIndexByOwner.Remove(FreedRecord.Owner);
+	FreedRecord.Owner = nullptr;
+	FreedRecord.ArchetypeIndex = INDEX_NONE;
+	++FreedRecord.Serial;
+	FreeEntityIndices.Add(Entity.Index);
+}
+
+bool UECSArchetypeSubsystem::IsValidEntity(FECSEntityHandle Entity) const
+{
+	return FindRecord(Entity) != nullptr;
+}
+
+const UECSArchetypeSubsystem::FEntityRecord* UECSArchetypeSubsystem::FindRecord(FECSEntityHandle Entity) const
+{
+	if (!Entities.IsValidIndex(Entity.Index))
+	{
+		return nullptr;
+	}
+
+	const FEntityRecord& Record = Entities[Entity.Index];
+	return (Record.Serial == Entity.Serial && Record.ArchetypeIndex != INDEX_NONE) ? &Record : nullptr;
+}
+
+void* UECSArchetypeSubsystem::GetFragmentMemory(FECSEntityHandle Entity, const UScriptStruct* FragmentType) const
+{
+	const FEntityRecord* Record = FindRecord(Entity);
+	if (!Record)
+	{
+		return nullptr;
+	}
+
+	const FECSArchetype& Archetype = Archetypes[Record->ArchetypeIndex];
+	const int32 Column = Archetype.FindColumn(FragmentType);
+	return Column != INDEX_NONE ? Archetype.GetFragmentMemory(Record->ChunkIndex, Record->Row, Column) : nullptr;
+}
+
+void UECSArchetypeSubsystem::ForEachChunk(TConstArrayView<const UScriptStruct*> RequiredTypes, TFunctionRef<void(const FECSChunkView&)> Visitor) const
+{
+	++IterationDepth;
+
+	for (const FECSArchetype& Archetype : Archetypes)
+	{
+		if (Archetype.NumEntities == 0)
+		{
+			continue;
+		}
+
+		bool bMatches = true;
+		for (const UScriptStruct* RequiredType : RequiredTypes)
+		{
+			if (Archetype.FindColumn(RequiredType) == INDEX_NONE)
+			{
+				bMatches = false;
+				break;
+			}
+		}
+
+		if (!bMatches)
+		{
+			continue;
+		}
+
+		for (int32 ChunkIndex = 0; ChunkIndex < Archetype.Chunks.Num(); ++ChunkIndex)
+		{
+			const FECSArchetypeChunk& Chunk = Archetype.Chunks[ChunkIndex];
+
+			FECSChunkView View;
+			View.Archetype = &Archetype;
+			View.ChunkIndex = ChunkIndex;
+			View.Num = Chunk.NumRows;
+			View.Owners = TArrayView<AActor* const>(Chunk.Owners.GetData(), Chunk.NumRows);
+			Visitor(View);
+		}
+	}
+
+	--IterationDepth;
+}
+
+int32 UECSArchetypeSubsystem::FindOrAddArchetype(TArray<const UScriptStruct*> FragmentTypes)
+{
+	FragmentTypes.Sort();
+
+	for (int32 ArchetypeIndex = 0; ArchetypeIndex < Archetypes.Num(); ++ArchetypeIndex)
+	{
+		if (Archetypes[ArchetypeIndex].FragmentTypes == FragmentTypes)
+		{
+			return ArchetypeIndex;
+		}
+	}
+
+	FECSArchetype& Archetype = Archetypes.AddDefaulted_GetRef();
+	Archetype.FragmentTypes = MoveTemp(FragmentTypes);
+
+	// Fit as many rows as the target chunk size allows, but always at least one
+	int32 RowBytes = 0;
+	for (const UScriptStruct* FragmentType : Archetype.FragmentTypes)
+	{
+		RowBytes += FragmentType->GetStructureSize();
+		Archetype.ChunkAlignment = FMath::Max(Archetype.ChunkAlignment, FragmentType->GetMinAlignment());
+	}
+	Archetype.ChunkCapacity = FMath::Max(1, CVarECSArchetypeChunkBytes.GetValueOnGameThread() / FMath::Max(RowBytes, 1));
+
+	// Columns back to back, each starting aligned for its struct
+	int32 Offset = 0;
+	for (const UScriptStruct* FragmentType : Archetype.FragmentTypes)
+	{
+		Offset = Align(Offset, FragmentType->GetMinAlignment());
+		Archetype.ColumnOffsets.Add(Offset);
+		Offset += FragmentType->GetStructureSize() * Archetype.ChunkCapacity;
+	}
+	Archetype.ChunkBytes = FMath::Max(Offset, 1);
+
+	return Archetypes.Num() - 1;
+}
+
+void UECSArchetypeSubsystem::AddRow(int32 EntityIndex, int32 ArchetypeIndex)
+{
+	FECSArchetype& Archetype = Archetypes[ArchetypeIndex];
+
+	// Only the last chunk can have free rows
+	if (Archetype.Chunks.IsEmpty() || Archetype.Chunks.Last().NumRows == Archetype.ChunkCapacity)
+	{
+		FECSArchetypeChunk& NewChunk = Archetype.Chunks.AddDefaulted_GetRef();
+		NewChunk.Memory = static_cast<uint8*>(FMemory::Malloc(Archetype.ChunkBytes, Archetype.ChunkAlignment));
+		NewChunk.EntityIndices.SetNumUninitialized(Archetype.ChunkCapacity);
+		NewChunk.Owners.SetNumZeroed(Archetype.ChunkCapacity);
+	}
+
+	const int32 ChunkIndex = Archetype.Chunks.Num() - 1;
+	FECSArchetypeChunk& Chunk = Archetype.Chunks[ChunkIndex];
+	const int32 Row = Chunk.NumRows++;
+	Chunk.EntityIndices[Row] = EntityIndex;
+	Chunk.Owners[Row] = Entities[EntityIndex].Owner;
+	++Archetype.NumEntities;
+
+	FEntityRecord& Record = Entities[EntityIndex];
+	Record.ArchetypeIndex = ArchetypeIndex;
+	Record.ChunkIndex = ChunkIndex;
+	Record.Row = Row;
+}
+
+void UECSArchetypeSubsystem::RemoveRow(int32 EntityIndex, bool bDestroyFragments)
+{
+	const FEntityRecord& Record = Entities[EntityIndex];
+	FECSArchetype& Archetype = Archetypes[Record.ArchetypeIndex];
+
+	if (bDestroyFragments)
+	{
+		for (int32 Column = 0; Column < Archetype.FragmentTypes.Num(); ++Column)
+		{
+			Archetype.FragmentTypes[Column]->DestroyStruct(Archetype.GetFragmentMemory(Record.ChunkIndex, Record.Row, Column));
+		}
+	}
+
+	// Relocate the archetype's last row into the hole, structs are bitwise relocatable like in any TArray
+	const int32 LastChunkIndex = Archetype.Chunks.Num() - 1;
+	FECSArchetypeChunk& LastChunk = Archetype.Chunks[LastChunkIndex];
+	const int32 LastRow = LastChunk.NumRows - 1;
+	if (LastChunkIndex != Record.ChunkIndex || LastRow != Record.Row)
+	{
+		for (int32 Column = 0; Column < Archetype.FragmentTypes.Num(); ++Column)
+		{
+			FMemory::Memcpy(
+				Archetype.GetFragmentMemory(Record.ChunkIndex, Record.Row, Column),
+				Archetype.GetFragmentMemory(LastChunkIndex, LastRow, Column),
+				Archetype.FragmentTypes[Column]->GetStructureSize());
+		}
+
+		const int32 MovedEntityIndex = LastChunk.EntityIndices[LastRow];
+		FECSArchetypeChunk& Chunk = Archetype.Chunks[Record.ChunkIndex];
+		Chunk.EntityIndices[Record.Row] = MovedEntityIndex;
+		Chunk.Owners[Record.Row] = LastChunk.Owners[LastRow];
+
+		FEntityRecord& MovedRecord = Entities[MovedEntityIndex];
+		MovedRecord.ChunkIndex = Record.ChunkIndex;
+		MovedRecord.Row = Record.Row;
+	}
+
+	LastChunk.Owners[LastRow] = nullptr;
+	--LastChunk.NumRows;
+	--Archetype.NumEntities;
+
+	if (LastChunk.NumRows == 0)
+	{
+		FMemory::Free(LastChunk.Memory);
+		Archetype.Chunks.Pop(EAllowShrinking::No);
+	}
+}
+
+void UECSArchetypeSubsystem::MoveEntity(int32 EntityIndex, int32 NewArchetypeIndex)
+{
+	// Copy the record, RemoveRow below rewrites it
+	const FEntityRecord OldRecord = Entities[EntityIndex];
+	AddRow(EntityIndex, NewArchetypeIndex);
+
+	const FECSArchetype& OldArchetype = Archetypes[OldRecord.ArchetypeIndex];
+	const FEntityRecord& NewRecord = Entities[EntityIndex];
+	const FECSArchetype& NewArchetype = Archetypes[NewArchetypeIndex];
+	for (int32 Column = 0; Column < NewArchetype.FragmentTypes.Num(); ++Column)
+	{
+		const UScriptStruct* FragmentType = NewArchetype.FragmentTypes[Column];
+		uint8* NewMemory = NewArchetype.GetFragmentMemory(NewRecord.ChunkIndex, NewRecord.Row, Column);
+		const int32 OldColumn = OldArchetype.FindColumn(FragmentType);
+		if (OldColumn != INDEX_NONE)
+		{
+			FMemory::Memcpy(NewMemory, OldArchetype.GetFragmentMemory(OldRecord.ChunkIndex, OldRecord.Row, OldColumn), FragmentType->GetStructureSize());
+		}
+		else
+		{
+			FragmentType->InitializeStruct(NewMemory);
+		}
+	}
+
+	// Fragments that moved were relocated, only those that didn't make it into the new archetype are destroyed
+	for (int32 OldColumn = 0; OldColumn < OldArchetype.FragmentTypes.Num(); ++OldColumn)
+	{
+		if (NewArchetype.FindColumn(OldArchetype.FragmentTypes[OldColumn]) == INDEX_NONE)
+		{
+			OldArchetype.FragmentTypes[OldColumn]->DestroyStruct(OldArchetype.GetFragmentMemory(OldRecord.ChunkIndex, OldRecord.Row, OldColumn));
+		}
+	}
+
+	// Temporarily point the record at the old row so RemoveRow frees it without destroying relocated fragments
+	const FEntityRecord NewRecordCopy = NewRecord;
+	Entities[EntityIndex] = OldRecord;
+	RemoveRow(EntityIndex, false);
+
+	// RemoveRow may have moved the old archetype's last entity, which is never this one's new row
+	FEntityRecord& Record = Entities[EntityIndex];
+	Record.ArchetypeIndex = NewRecordCopy.ArchetypeIndex;
+	Record.ChunkIndex = NewRecordCopy.ChunkIndex;
+	Record.Row = NewRecordCopy.Row;
+}
@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ECSFragment.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Templates/Function.h"
+
+#include "ECSArchetypeSubsystem.generated.h"
+
+/**
+ * Fixed-size block of an archetype's entities. Every fragment type has its own column, so iterating one fragment
+ * across a chunk is a linear walk through contiguous memory.
+ */
+struct FECSArchetypeChunk
+{
+	uint8* Memory = nullptr;
+	int32 NumRows = 0;
+
+	// Entity index and owning actor of each row
+	TArray<int32> EntityIndices;
+	TArray<AActor*> Owners;
+};
+
+/**
+ * All entities that have exactly the same set of fragment types.
+ * Rows are kept dense - every chunk but the last is full, removals swap the archetype's last row into the hole.
+ */
+struct FECSArchetype
+{
+	// Sorted by pointer, so a fragment set maps to a single archetype
+	TArray<const UScriptStruct*> FragmentTypes;
+	TArray<int32> ColumnOffsets;
+
+	int32 ChunkCapacity = 0;
+	int32 ChunkBytes = 0;
+	int32 ChunkAlignment = 16;
+
+	TArray<FECSArchetypeChunk> Chunks;
+	int32 NumEntities = 0;
+
+	int32 FindColumn(const UScriptStruct* FragmentType) const { return FragmentTypes.Find(FragmentType); }
+
+	uint8* GetFragmentMemory(int32 ChunkIndex, int32 Row, int32 Column) const
+	{
+		return Chunks[ChunkIndex].Memory + ColumnOffsets[Column] + Row * FragmentTypes[Column]->GetStructureSize();
+	}
+};
+
+/**
+ * One chunk as seen by ForEachChunk - contiguous fragment columns and the actors owning each row.
+ */
+struct CREATIVEGAME_API FECSChunkView
+{
+	const FECSArchetype* Archetype = nullptr;
+	int32 ChunkIndex = INDEX_NONE;
+	int32 Num = 0;
+	TArrayView<AActor* const> Owners;
+
+	// Column of FragmentType in this chunk, empty if the archetype doesn't have it
+	void* GetFragmentColumn(const UScriptStruct* FragmentType) const;
+
+	template<typename T>
+	TArrayView<T> GetFragments() const
+	{
+		T* Column = static_cast<T*>(GetFragmentColumn(T::StaticStruct()));
+		return TArrayView<T>(Column, Column ? Num : 0);
+	}
+};
+
+/**
+ * Opt-in struct-of-arrays storage for component data.
+ * Components that set a FragmentType keep their data here as a USTRUCT fragment instead of as properties scattered
+ * across the heap. Every actor with fragments is one entity, and entities with the same fragment set share an archetype
+ * whose chunks store each fragment type contiguously. UBaseComponent stays as a thin handle for Blueprint access,
+ * while capabilities that process many entities use ForEachChunk for linear, prefetch-friendly access.
+ *
+ * Structural changes (adding or removing fragments) are not allowed while ForEachChunk is running.
+ */
+UCLASS()
+class CREATIVEGAME_API UECSArchetypeSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Convenience accessor for the subsystem of a world context object's world
+	static UECSArchetypeSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
+	// Add a default-initialized fragment to the owner's entity, creating the entity if needed.
+	// Adding a type the entity already has shares the existing fragment, it stays until every add was matched by a remove.
+	FECSEntityHandle AddFragment(AActor* Owner, const UScriptStruct* FragmentType);
+
+	// Remove a fragment, the entity is destroyed along with its last fragment
+	void RemoveFragment(FECSEntityHandle Entity, const UScriptStruct* FragmentType);
+
+	bool IsValidEntity(FECSEntityHandle Entity) const;
+
+	// Fragment memory of an entity, only valid until the next structural change
+	void* GetFragmentMemory(FECSEntityHandle Entity, const UScriptStruct* FragmentType) const;
+
+	template<typename T>
+	T* GetFragment(FECSEntityHandle Entity) const
+	{
+		return static_cast<T*>(GetFragmentMemory(Entity, T::StaticStruct()));
+	}
+
+	// Visit every chunk whose archetype has all RequiredTypes
+	void ForEachChunk(TConstArrayView<const UScriptStruct*> RequiredTypes, TFunctionRef<void(const FECSChunkView&)> Visitor) const;
+
+	UFUNCTION(BlueprintPure, Category = "ECS")
+	int32 GetNumEntities() const { return Entities.Num() - FreeEntityIndices.Num(); }
+
+	UFUNCTION(BlueprintPure, Category = "ECS")
+	int32 GetNumArchetypes() const { return Archetypes.Num(); }
+
+private:
+	struct FEntityRecord
+	{
+		AActor* Owner = nullptr;
+		int32 ArchetypeIndex = INDEX_NONE;
+		int32 ChunkIndex = INDEX_NONE;
+		int32 Row = INDEX_NONE;
+		uint32 Serial = 0;
+	};
+
+	int32 FindOrAddArchetype(TArray<const UScriptStruct*> FragmentTypes);
+	void AddRow(int32 EntityIndex, int32 ArchetypeIndex);
+	void RemoveRow(int32 EntityIndex, bool bDestroyFragments);
+	void MoveEntity(int32 EntityIndex, int32 NewArchetypeIndex);
+	const FEntityRecord* FindRecord(FECSEntityHandle Entity) const;
+
+	TArray<FECSArchetype> Archetypes;
+	TArray<FEntityRecord> Entities;
+	TArray<int32> FreeEntityIndices;
+	TMap<const AActor*, int32> EntityIndexByOwner;
+
+	// Adds beyond the first of a fragment type on an entity, keyed by entity index
+	TMap<TPair<int32, const UScriptStruct*>, int32> ExtraFragmentRefs;
+
+	mutable int32 IterationDepth = 0;
+};
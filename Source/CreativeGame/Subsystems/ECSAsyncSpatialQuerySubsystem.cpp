@@ -0,0 +1,332 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ECSAsyncSpatialQuerySubsystem.h"
+#include "ECSActorRegistrySubsystem.h"
+#include "ECSSpatialStats.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "LatentActions.h"
+
+DECLARE_CYCLE_STAT(TEXT("Async Query Snapshot"), STAT_ECSSpatial_AsyncSnapshot, STATGROUP_ECSSpatial);
+DECLARE_CYCLE_STAT(TEXT("Async Query Resolve"), STAT_ECSSpatial_AsyncResolve, STATGROUP_ECSSpatial);
+DECLARE_CYCLE_STAT(TEXT("Async Query Worker"), STAT_ECSSpatial_AsyncWorker, STATGROUP_ECSSpatial);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async Queries"), STAT_ECSSpatial_NumAsyncQueries, STATGROUP_ECSSpatial);
+
+/**
+ * Result of a Blueprint async query, shared between the query callback and the latent action polling it.
+ */
+struct FECSAsyncSpatialQueryState
+{
+	TArray<AActor*> Actors;
+	bool bResolved = false;
+};
+
+/**
+ * Latent action completing once its query resolved, writing the result to the node's output pin.
+ */
+class FECSAsyncSpatialQueryAction : public FPendingLatentAction
+{
+public:
+	FECSAsyncSpatialQueryAction(const FLatentActionInfo& LatentInfo, TSharedRef<FECSAsyncSpatialQueryState> InState, TUniqueFunction<void(TArray<AActor*>&&)> InWriteOutput)
+		: ExecutionFunction(LatentInfo.ExecutionFunction)
+		, OutputLink(LatentInfo.Linkage)
+		, CallbackTarget(LatentInfo.CallbackTarget)
+		, State(InState)
+		, WriteOutput(MoveTemp(InWriteOutput))
+	{
+	}
+
+	virtual void UpdateOperation(FLatentResponse& Response) override
+	{
+		if (State->bResolved)
+		{
+			WriteOutput(MoveTemp(State->Actors));
+		}
+		Response.FinishAndTriggerIf(State->bResolved, ExecutionFunction, OutputLink, CallbackTarget);
+	}
+
+private:
+	FName ExecutionFunction;
+	int32 OutputLink;
+	FWeakObjectPtr CallbackTarget;
+	TSharedRef<FECSAsyncSpatialQueryState> State;
+	TUniqueFunction<void(TArray<AActor*>&&)> WriteOutput;
+};
+
+UECSAsyncSpatialQuerySubsystem* UECSAsyncSpatialQuerySubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UECSAsyncSpatialQuerySubsystem>() : nullptr;
+}
+
+bool UECSAsyncSpatialQuerySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// ECS actors only register once they begin play
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UECSAsyncSpatialQuerySubsystem::Deinitialize()
+{
+	ResolveInFlightQueries();
+
+	// Nobody waits forever on a future - queries that never reached a worker resolve empty.
+	// Callbacks may issue new queries, those are resolved by the next pass instead of growing the list being iterated.
+	while (!QueuedQueries.IsEmpty())
+	{
+		TArray<FECSAsyncSpatialQuery> Resolving = MoveTemp(QueuedQueries);
+		QueuedQueries.Reset();
+
+		for (FECSAsyncSpatialQuery& Query : Resolving)
+		{
+			Query.OnResolved(TArray<AActor*>());
+		}
+	}
+
+	Super::Deinitialize();
+}
+
+TStatId UECSAsyncSpatialQuerySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UECSAsyncSpatialQuerySubsystem, STATGROUP_Tickables);
+}
+
+void UECSAsyncSpatialQuerySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Write the back snapshot while the worker may still be reading the front one
+	FECSSpatialSnapshot& BackSnapshot = Snapshots[1 - FrontSnapshot];
+	const bool bRefreshedSnapshot = !QueuedQueries.IsEmpty();
+	if (bRefreshedSnapshot)
+	{
+		RefreshSnapshot(BackSnapshot);
+	}
+
+	// Last frame's batch has had a whole frame to finish
+	ResolveInFlightQueries();
+
+	if (QueuedQueries.IsEmpty())
+	{
+		return;
+	}
+
+	// Callbacks above may have issued the first queries of this frame
+	if (!bRefreshedSnapshot)
+	{
+		RefreshSnapshot(BackSnapshot);
+	}
+
+	FrontSnapshot = 1 - FrontSnapshot;
+	InFlightQueries = MoveTemp(QueuedQueries);
+	QueuedQueries.Reset();
+
+	INC_DWORD_STAT_BY(STAT_ECSSpatial_NumAsyncQueries, InFlightQueries.Num());
+	InFlightTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Snapshot = &Snapshots[FrontSnapshot], Queries = &InFlightQueries]()
+	{
+		RunQueries(*Snapshot, *Queries);
+	});
+}
+
+void UECSAsyncSpatialQuerySubsystem::RefreshSnapshot(FECSSpatialSnapshot& Snapshot) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ECSSpatial_AsyncSnapshot);
+
+	Snapshot.Positions.Reset();
+	Snapshot.Classes.Reset();
+	Snapshot.Actors.Reset();
+	Snapshot.WeakActors.Reset();
+
+	if (const UECSActorRegistrySubsystem* Registry = UECSActorRegistrySubsystem::Get(this))
+	{
+		Registry->ForEachActorOfClass(nullptr, [&Snapshot](AActor* Actor)
+		{
+			Snapshot.Positions.Add(FVector3f(Actor->GetActorLocation()));
+			Snapshot.Classes.Add(Actor->GetClass());
+			Snapshot.Actors.Add(Actor);
+			Snapshot.WeakActors.Add(Actor);
+		});
+	}
+}
+
+void UECSAsyncSpatialQuerySubsystem::ResolveInFlightQueries()
+{
+	if (InFlightQueries.IsEmpty())
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ECSSpatial_AsyncResolve);
+
+	InFlightTask.Wait();
+
+	// Callbacks may issue new queries, those go to QueuedQueries and don't touch this list
+	TArray<FECSAsyncSpatialQuery> Resolving = MoveTemp(InFlightQueries);
+	InFlightQueries.Reset();
+
+	const FECSSpatialSnapshot& Snapshot = Snapshots[FrontSnapshot];
+	for (FECSAsyncSpatialQuery& Query : Resolving)
+	{
+		// Actors destroyed since the snapshot are dropped
+		TArray<AActor*> Actors;
+		Actors.Reserve(Query.ResultIndices.Num());
+		for (const int32 Index : Query.ResultIndices)
+		{
+			if (AActor* Actor = Snapshot.WeakActors[Index].Get())
+			{
+				Actors.Add(Actor);
+			}
+		}
+		Query.OnResolved(MoveTemp(Actors));
+	}
+}
+
+void UECSAsyncSpatialQuerySubsystem::RunQueries(const FECSSpatialSnapshot& Snapshot, TArray<FECSAsyncSpatialQuery>& Queries)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ECSSpatial_AsyncWorker);
+
+	const int32 NumActors = Snapshot.Positions.Num();
+	for (FECSAsyncSpatialQuery& Query : Queries)
+	{
+		if (Query.Type == EECSAsyncSpatialQueryType::Radius)
+		{
+			for (int32 Index = 0; Index < NumActors; ++Index)
+			{
+				if (FVector3f::DistSquared(Snapshot.Positions[Index], Query.Origin) <= Query.RadiusSquared
+					&& Snapshot.Actors[Index] != Query.IgnoreActor
+					&& (!Query.ClassFilter || Snapshot.Classes[Index]->IsChildOf(Query.ClassFilter)))
+				{
+					Query.ResultIndices.Add(Index);
+				}
+			}
+			continue;
+		}
+
+		int32 ClosestIndex = INDEX_NONE;
+		float ClosestDistanceSquared = TNumericLimits<float>::Max();
+		for (int32 Index = 0; Index < NumActors; ++Index)
+		{
+			const float DistanceSquared = FVector3f::DistSquared(Snapshot.Positions[Index], Query.Origin);
+			if (DistanceSquared < ClosestDistanceSquared
+				&& Snapshot.Actors[Index] != Query.IgnoreActor
+				&& (!Query.ClassFilter || Snapshot.Classes[Index]->IsChildOf(Query.ClassFilter)))
+			{
+				ClosestDistanceSquared = DistanceSquared;
+				ClosestIndex = Index;
+			}
+		}
+
+		if (ClosestIndex != INDEX_NONE)
+		{
+			Query.ResultIndices.Add(ClosestIndex);
+		}
+	}
+}
+
+void UECSAsyncSpatialQuerySubsystem::EnqueueQuery(FECSAsyncSpatialQuery&& Query)
+{
+	check(IsInGameThread());
+	QueuedQueries.Add(MoveTemp(Query));
+}
+
+void UECSAsyncSpatialQuerySubsystem::EnqueueRadiusQuery(const FVector& Origin, float Radius, const UClass* ClassFilter, const AActor* IgnoreActor, TUniqueFunction<void(TArray<AActor*>&&)> OnResolved)
+{
+	FECSAsyncSpatialQuery Query;
+	Query.Type = EECSAsyncSpatialQueryType::Radius;
+	Query.Origin = FVector3f(Origin);
+	Query.RadiusSquared = Radius >= 0.0f ? FMath::Square(Radius) : -1.0f;
+	Query.ClassFilter = ClassFilter;
+	Query.IgnoreActor = IgnoreActor;
+	Query.OnResolved = MoveTemp(OnResolved);
+	EnqueueQuery(MoveTemp(Query));
+}
+
+void UECSAsyncSpatialQuerySubsystem::EnqueueClosestQuery(const FVector& Origin, const UClass* ClassFilter, const AActor* IgnoreActor, TUniqueFunction<void(TArray<AActor*>&&)> OnResolved)
+{
+	FECSAsyncSpatialQuery Query;
+	Query.Type = EECSAsyncSpatialQueryType::Closest;
+	Query.Origin = FVector3f(Origin);
+	Query.ClassFilter = ClassFilter;
+	Query.IgnoreActor = IgnoreActor;
+	Query.OnResolved = MoveTemp(OnResolved);
+	EnqueueQuery(MoveTemp(Query));
+}
+
+TFuture<TArray<AActor*>> UECSAsyncSpatialQuerySubsystem::QueryRadiusAsync(const FVector& Origin, float Radius, const UClass* ClassFilter, const AActor* IgnoreActor)
+{
+	TSharedRef<TPromise<TArray<AActor*>>> Promise = MakeShared<TPromise<TArray<AActor*>>>();
+	TFuture<TArray<AActor*>> Future = Promise->GetFuture();
+	EnqueueRadiusQuery(Origin, Radius, ClassFilter, IgnoreActor, [Promise](TArray<AActor*>&& Actors)
+	{
+		Promise->SetValue(MoveTemp(Actors));
+	});
+	return Future;
+}
+
+TFuture<AActor*> UECSAsyncSpatialQuerySubsystem::QueryClosestAsync(const FVector& Origin, const UClass* ClassFilter, const AActor* IgnoreActor)
+{
+	TSharedRef<TPromise<AActor*>> Promise = MakeShared<TPromise<AActor*>>();
+	TFuture<AActor*> Future = Promise->GetFuture();
+	EnqueueClosestQuery(Origin, ClassFilter, IgnoreActor, [Promise](TArray<AActor*>&& Actors)
+	{
+		Promise->SetValue(Actors.IsEmpty() ? nullptr : Actors[0]);
+	});
+	return Future;
+}
+
+void UECSAsyncSpatialQuerySubsystem::GetNearbyECSActorsAsync(UObject* WorldContextObject, FVector Origin, float Radius, TSubclassOf<AActor> ActorClass, AActor* IgnoreActor, TArray<AActor*>& OutActors, FLatentActionInfo LatentInfo)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	UECSAsyncSpatialQuerySubsystem* Subsystem = Get(World);
+	if (!Subsystem)
+	{
+		return;
+	}
+
+	// Same behaviour as other latent nodes, re-entering a node that is still pending does nothing
+	FLatentActionManager& LatentActionManager = World->GetLatentActionManager();
+	if (LatentActionManager.FindExistingAction<FECSAsyncSpatialQueryAction>(LatentInfo.CallbackTarget, LatentInfo.UUID))
+	{
+		return;
+	}
+
+	TSharedRef<FECSAsyncSpatialQueryState> State = MakeShared<FECSAsyncSpatialQueryState>();
+	Subsystem->EnqueueRadiusQuery(Origin, Radius, ActorClass, IgnoreActor, [State](TArray<AActor*>&& Actors)
+	{
+		State->Actors = MoveTemp(Actors);
+		State->bResolved = true;
+	});
+
+	LatentActionManager.AddNewAction(LatentInfo.CallbackTarget, LatentInfo.UUID, new FECSAsyncSpatialQueryAction(LatentInfo, State, [&OutActors](TArray<AActor*>&& Actors)
+	{
+		OutActors = MoveTemp(Actors);
+	}));
+}
+
+void UECSAsyncSpatialQuerySubsystem::GetClosestECSActorAsync(UObject* WorldContextObject, FVector Origin, TSubclassOf<AActor> ActorClass, AActor* IgnoreActor, AActor*& OutActor, FLatentActionInfo LatentInfo)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	UECSAsyncSpatialQuerySubsystem* Subsystem = Get(World);
+	if (!Subsystem)
+	{
+		return;
+	}
+
+	FLatentActionManager& LatentActionManager = World->GetLatentActionManager();
+	if (LatentActionManager.FindExistingAction<FECSAsyncSpatialQueryAction>(LatentInfo.CallbackTarget, LatentInfo.UUID))
+	{
+		return;
+	}
+
+	TSharedRef<FECSAsyncSpatialQueryState> State = MakeShared<FECSAsyncSpatialQueryState>();
+	Subsystem->EnqueueClosestQuery(Origin, ActorClass, IgnoreActor, [State](TArray<AActor*>&& Actors)
+	{
+		State->Actors = MoveTemp(Actors);
+		State->bResolved = true;
+	});
+
+	LatentActionManager.AddNewAction(LatentInfo.CallbackTarget, LatentInfo.UUID, new FECSAsyncSpatialQueryAction(LatentInfo, State, [&OutActor](TArray<AActor*>&& Actors)
+	{
+		OutActor = Actors.IsEmpty() ? nullptr : Actors[0];
+	}));
+}
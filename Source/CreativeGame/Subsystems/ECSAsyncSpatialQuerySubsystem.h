@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Engine/LatentActionManager.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+
+#include "ECSAsyncSpatialQuerySubsystem.generated.h"
+
+/**
+ * Positions of every registered ECS actor at the end of a frame. Workers only read the plain arrays,
+ * the weak pointers are resolved back on the game thread.
+ */
+struct FECSSpatialSnapshot
+{
+	TArray<FVector3f> Positions;
+	TArray<const UClass*> Classes;
+
+	// Identity for IgnoreActor checks on workers, never dereferenced there
+	TArray<const AActor*> Actors;
+	TArray<TWeakObjectPtr<AActor>> WeakActors;
+};
+
+enum class EECSAsyncSpatialQueryType : uint8
+{
+	Radius,
+	Closest
+};
+
+/**
+ * A query waiting for, or being answered by, the worker.
+ */
+struct FECSAsyncSpatialQuery
+{
+	EECSAsyncSpatialQueryType Type = EECSAsyncSpatialQueryType::Radius;
+	FVector3f Origin = FVector3f::ZeroVector;
+	float RadiusSquared = 0.0f;
+	const UClass* ClassFilter = nullptr;
+	const AActor* IgnoreActor = nullptr;
+
+	// Snapshot indices of the matches, written by the worker
+	TArray<int32> ResultIndices;
+
+	// Called on the game thread with the matches that are still alive
+	TUniqueFunction<void(TArray<AActor*>&&)> OnResolved;
+};
+
+/**
+ * Spatial queries answered on a worker thread, for callers that can wait a frame for the result.
+ *
+ * Queries issued during a frame are collected and handed to a single worker task when the subsystem ticks at the end
+ * of the frame. The task reads a snapshot of every registered ECS actor's position taken at that point, and the results
+ * are resolved on the game thread at the next tick. Snapshots are double-buffered: the next one is written while the
+ * worker may still be reading the current one, and a snapshot is only reused once the batch reading it has resolved.
+ *
+ * C++ callers get a TFuture, Blueprint callers the GetNearbyECSActorsAsync and GetClosestECSActorAsync latent nodes.
+ * Results are resolved on the game thread, so continuations may touch the actors directly.
+ */
+UCLASS()
+class CREATIVEGAME_API UECSAsyncSpatialQuerySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Convenience accessor for the subsystem of a world context object's world
+	static UECSAsyncSpatialQuerySubsystem* Get(const UObject* WorldContextObject);
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Registered actors of ClassFilter (or any class when null) within Radius of Origin, resolved next frame
+	TFuture<TArray<AActor*>> QueryRadiusAsync(const FVector& Origin, float Radius, const UClass* ClassFilter, const AActor* IgnoreActor = nullptr);
+
+	// Closest registered actor of ClassFilter (or any class when null), resolved next frame, null if there is none
+	TFuture<AActor*> QueryClosestAsync(const FVector& Origin, const UClass* ClassFilter, const AActor* IgnoreActor = nullptr);
+
+	// Callback versions of the above, OnResolved runs on the game thread
+	void EnqueueRadiusQuery(const FVector& Origin, float Radius, const UClass* ClassFilter, const AActor* IgnoreActor, TUniqueFunction<void(TArray<AActor*>&&)> OnResolved);
+	void EnqueueClosestQuery(const FVector& Origin, const UClass* ClassFilter, const AActor* IgnoreActor, TUniqueFunction<void(TArray<AActor*>&&)> OnResolved);
+
+	// Latent version of GetNearbyECSActors, completes next frame without blocking the game thread on the query
+	UFUNCTION(BlueprintCallable, Category = "ECS", meta = (Latent, LatentInfo = "LatentInfo", WorldContext = "WorldContextObject"))
+	static void GetNearbyECSActorsAsync(UObject* WorldContextObject, FVector Origin, float Radius, TSubclassOf<AActor> ActorClass, AActor* IgnoreActor, TArray<AActor*>& OutActors, FLatentActionInfo LatentInfo);
+
+	// Latent version of GetClosestECSActor, completes next frame
+	UFUNCTION(BlueprintCallable, Category = "ECS", meta = (Latent, LatentInfo = "LatentInfo", WorldContext = "WorldContextObject"))
+	static void GetClosestECSActorAsync(UObject* WorldContextObject, FVector Origin, TSubclassOf<AActor> ActorClass, AActor* IgnoreActor, AActor*& OutActor, FLatentActionInfo LatentInfo);
+
+	UFUNCTION(BlueprintPure, Category = "ECS")
+	int32 GetNumPendingQueries() const { return QueuedQueries.Num() + InFlightQueries.Num(); }
+
+private:
+	void EnqueueQuery(FECSAsyncSpatialQuery&& Query);
+	void RefreshSnapshot(FECSSpatialSnapshot& Snapshot) const;
+	void ResolveInFlightQueries();
+	static void RunQueries(const FECSSpatialSnapshot& Snapshot, TArray<FECSAsyncSpatialQuery>& Queries);
+
+	FECSSpatialSnapshot Snapshots[2];
+	int32 FrontSnapshot = 0;
+
+	// Issued since the last tick
+	TArray<FECSAsyncSpatialQuery> QueuedQueries;
+
+	// Being answered by InFlightTask from Snapshots[FrontSnapshot], untouched by the game thread until it completes
+	TArray<FECSAsyncSpatialQuery> InFlightQueries;
+	UE::Tasks::FTask InFlightTask;
+};
@@ -0,0 +1,229 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ECSNearestNeighborSubsystem.h"
+#include "ECSActorRegistrySubsystem.h"
+#include "ECSSpatialStats.h"
+#include "Async/ParallelFor.h"
+#include "CoreGlobals.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include <algorithm>
+
+DECLARE_CYCLE_STAT(TEXT("KNN Tree Build"), STAT_ECSSpatial_KnnBuild, STATGROUP_ECSSpatial);
+DECLARE_CYCLE_STAT(TEXT("KNN Batch Query"), STAT_ECSSpatial_KnnQuery, STATGROUP_ECSSpatial);
+DECLARE_DWORD_COUNTER_STAT(TEXT("KNN Queries"), STAT_ECSSpatial_NumKnnQueries, STATGROUP_ECSSpatial);
+
+static TAutoConsoleVariable<int32> CVarECSSpatialKnnParallelBuildMin(
+	TEXT("ECS.Spatial.KNN.ParallelBuildMin"),
+	4096,
+	TEXT("k-d tree ranges with at least this many points build their two halves on worker threads."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarECSSpatialKnnParallelQueryMin(
+	TEXT("ECS.Spatial.KNN.ParallelQueryMin"),
+	32,
+	TEXT("Batches with fewer query points than this are answered on the calling thread."),
+	ECVF_Default);
+
+void FECSKdTree::Build(int32 ParallelMinPoints)
+{
+	SplitAxes.SetNumUninitialized(Points.Num());
+	BuildRange(0, Points.Num(), FMath::Max(ParallelMinPoints, 2));
+}
+
+void FECSKdTree::BuildRange(int32 Begin, int32 End, int32 ParallelMinPoints)
+{
+	if (End - Begin <= 1)
+	{
+		if (End > Begin)
+		{
+			SplitAxes[Begin] = 0;
+		}
+		return;
+	}
+
+	// Split along the widest axis of the range, so clustered actors still give balanced, tight subtrees
+	FVector3f Min = Points[Begin].Position;
+	FVector3f Max = Min;
+	for (int32 Index = Begin + 1; Index < End; ++Index)
+	{
+		Min = Min.ComponentMin(Points[Index].Position);
+		Max = Max.ComponentMax(Points[Index].Position);
+	}
+	const FVector3f Extent = Max - Min;
+	const uint8 Axis = Extent.X >= Extent.Y ? (Extent.X >= Extent.Z ? 0 : 2) : (Extent.Y >= Extent.Z ? 1 : 2);
+
+	const int32 Mid = Begin + (End - Begin) / 2;
+	std::nth_element(Points.GetData() + Begin, Points.GetData() + Mid, Points.GetData() + End, [Axis](const FPoint& A, const FPoint& B)
+	{
+		return A.Position[Axis] < B.Position[Axis];
+	});
+	SplitAxes[Mid] = Axis;
+
+	// The halves are disjoint ranges of the same arrays, so they can be built concurrently
+	if (End - Begin >= ParallelMinPoints)
+	{
+		ParallelFor(2, [this, Begin, Mid, End, ParallelMinPoints](int32 Half)
+		{
+			Half == 0 ? BuildRange(Begin, Mid, ParallelMinPoints) : BuildRange(Mid + 1, End, ParallelMinPoints);
+		});
+		return;
+	}
+
+	BuildRange(Begin, Mid, ParallelMinPoints);
+	BuildRange(Mid + 1, End, ParallelMinPoints);
+}
+
+void FECSKdTree::FindNearest(const FVector3f& Origin, int32 K, const AActor* IgnoreActor, TArray<TPair<float, int32>, TInlineAllocator<16>>& OutNearest) const
+{
+	OutNearest.Reset();
+	if (K > 0)
+	{
+		SearchRange(0, Points.Num(), Origin, K, IgnoreActor, OutNearest);
+	}
+
+	// Max-heap while searching, closest first for the caller
+	OutNearest.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; });
+}
+
+void FECSKdTree::SearchRange(int32 Begin, int32 End, const FVector3f& Origin, int32 K, const AActor* IgnoreActor, TArray<TPair<float, int32>, TInlineAllocator<16>>& Nearest) const
+{
+	if (Begin >= End)
+	{
+		return;
+	}
+
+	// Heap ordered so Nearest[0] is the furthest of the current K candidates
+	auto FurtherFirst = [](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key > B.Key; };
+
+	const int32 Mid = Begin + (End - Begin) / 2;
+	const FPoint& Point = Points[Mid];
+	const float DistanceSquared = FVector3f::DistSquared(Point.Position, Origin);
+	if (Actors[Point.ActorIndex] != IgnoreActor)
+	{
+		if (Nearest.Num() < K)
+		{
+			Nearest.HeapPush(TPair<float, int32>(DistanceSquared, Point.ActorIndex), FurtherFirst);
+		}
+		else if (DistanceSquared < Nearest[0].Key)
+		{
+			Nearest.HeapPopDiscard(FurtherFirst, EAllowShrinking::No);
+			Nearest.HeapPush(TPair<float, int32>(DistanceSquared, Point.ActorIndex), FurtherFirst);
+		}
+	}
+
+	const uint8 Axis = SplitAxes[Mid];
+	const float PlaneDistance = Origin[Axis] - Point.Position[Axis];
+	const bool bNearIsLow = PlaneDistance < 0.0f;
+
+	SearchRange(bNearIsLow ? Begin : Mid + 1, bNearIsLow ? Mid : End, Origin, K, IgnoreActor, Nearest);
+
+	// The far side can only hold something closer if the splitting plane is within the current worst distance
+	if (Nearest.Num() < K || FMath::Square(PlaneDistance) < Nearest[0].Key)
+	{
+		SearchRange(bNearIsLow ? Mid + 1 : Begin, bNearIsLow ? End : Mid, Origin, K, IgnoreActor, Nearest);
+	}
+}
+
+UECSNearestNeighborSubsystem* UECSNearestNeighborSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UECSNearestNeighborSubsystem>() : nullptr;
+}
+
+bool UECSNearestNeighborSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// ECS actors only register once they begin play
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UECSNearestNeighborSubsystem::Deinitialize()
+{
+	Trees.Reset();
+
+	Super::Deinitialize();
+}
+
+const FECSKdTree& UECSNearestNeighborSubsystem::GetTree(const UClass* ClassFilter)
+{
+	TUniquePtr<FECSKdTree>& Tree = Trees.FindOrAdd(ClassFilter);
+	if (!Tree)
+	{
+		Tree = MakeUnique<FECSKdTree>();
+	}
+
+	// Actors move every frame, so a tree is only reused within the frame and while nothing registered or unregistered
+	const UECSActorRegistrySubsystem* Registry = UECSActorRegistrySubsystem::Get(this);
+	const uint32 Serial = Registry ? Registry->GetChangeSerial() : 0;
+	if (Tree->BuiltFrame == GFrameCounter && Tree->BuiltSerial == Serial && Tree->BuiltFrame != 0)
+	{
+		return *Tree;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ECSSpatial_KnnBuild);
+
+	Tree->BuiltFrame = GFrameCounter;
+	Tree->BuiltSerial = Serial;
+	Tree->Actors.Reset();
+	Tree->Points.Reset();
+
+	if (Registry)
+	{
+		// Positions are gathered on the game thread, the tree itself only sees plain data
+		Registry->ForEachActorOfClass(ClassFilter, [&Tree](AActor* Actor)
+		{
+			Tree->Points.Add({ FVector3f(Actor->GetActorLocation()), Tree->Actors.Add(Actor) });
+		});
+	}
+
+	Tree->Build(CVarECSSpatialKnnParallelBuildMin.GetValueOnGameThread());
+	return *Tree;
+}
+
+void UECSNearestNeighborSubsystem::FindKNearest(const UClass* ClassFilter, TConstArrayView<FVector> QueryPoints, int32 K, TArray<AActor*>& OutNeighbors,
+	TArray<float>* OutDistancesSquared, TConstArrayView<const AActor*> IgnoreActors)
+{
+	check(IsInGameThread());
+
+	K = FMath::Max(K, 0);
+	const int32 NumQueries = QueryPoints.Num();
+	OutNeighbors.Init(nullptr, NumQueries * K);
+	if (OutDistancesSquared)
+	{
+		OutDistancesSquared->Init(TNumericLimits<float>::Max(), NumQueries * K);
+	}
+
+	if (NumQueries == 0 || K == 0)
+	{
+		return;
+	}
+
+	const FECSKdTree& Tree = GetTree(ClassFilter);
+
+	SCOPE_CYCLE_COUNTER(STAT_ECSSpatial_KnnQuery);
+	INC_DWORD_STAT_BY(STAT_ECSSpatial_NumKnnQueries, NumQueries);
+
+	// Every query writes only its own K slots, so the batch needs no synchronisation
+	const bool bIgnorePerQuery = IgnoreActors.Num() == NumQueries;
+	const bool bSingleThread = NumQueries < CVarECSSpatialKnnParallelQueryMin.GetValueOnGameThread();
+	ParallelFor(NumQueries, [&](int32 QueryIndex)
+	{
+		TArray<TPair<float, int32>, TInlineAllocator<16>> Nearest;
+		Tree.FindNearest(FVector3f(QueryPoints[QueryIndex]), K, bIgnorePerQuery ? IgnoreActors[QueryIndex] : nullptr, Nearest);
+
+		for (int32 Rank = 0; Rank < Nearest.Num(); ++Rank)
+		{
+			OutNeighbors[QueryIndex * K + Rank] = Tree.Actors[Nearest[Rank].Value];
+			if (OutDistancesSquared)
+			{
+				(*OutDistancesSquared)[QueryIndex * K + Rank] = Nearest[Rank].Key;
+			}
+		}
+	}, bSingleThread ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
+
+void UECSNearestNeighborSubsystem::FindKNearestECSActors(TSubclassOf<AActor> ActorClass, const TArray<FVector>& QueryPoints, int32 K, TArray<AActor*>& OutNeighbors)
+{
+	FindKNearest(ActorClass, QueryPoints, K, OutNeighbors);
+}
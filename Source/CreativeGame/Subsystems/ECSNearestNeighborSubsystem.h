@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "ECSNearestNeighborSubsystem.generated.h"
+
+/**
+ * Implicit k-d tree over actor positions. Points are reordered so every range's median is its node,
+ * with the split axis stored alongside - no node structs, no pointers, one allocation per array.
+ */
+struct FECSKdTree
+{
+	struct FPoint
+	{
+		FVector3f Position;
+		int32 ActorIndex;
+	};
+
+	TArray<FPoint> Points;
+	TArray<uint8> SplitAxes;
+	TArray<AActor*> Actors;
+
+	// Frame and registry serial the tree was built for
+	uint64 BuiltFrame = 0;
+	uint32 BuiltSerial = 0;
+
+	// Sort Points into the tree, subtrees larger than ParallelMinPoints are built on worker threads
+	void Build(int32 ParallelMinPoints);
+
+	// Up to K nearest points to Origin by squared distance, closest first, skipping IgnoreActor
+	void FindNearest(const FVector3f& Origin, int32 K, const AActor* IgnoreActor, TArray<TPair<float, int32>, TInlineAllocator<16>>& OutNearest) const;
+
+private:
+	void BuildRange(int32 Begin, int32 End, int32 ParallelMinPoints);
+	void SearchRange(int32 Begin, int32 End, const FVector3f& Origin, int32 K, const AActor* IgnoreActor, TArray<TPair<float, int32>, TInlineAllocator<16>>& Nearest) const;
+};
+
+/**
+ * Batched k-nearest-neighbour queries over the registered ECS actors of a class.
+ * The first query for a class in a frame builds a k-d tree from UECSActorRegistrySubsystem, every later query that frame
+ * reuses it. A batch of query points is answered in parallel and candidates are compared by squared distance only.
+ *
+ * Use it when many agents ask for their closest targets in the same frame. For a single query the spatial hash's
+ * FindClosestActor is cheaper, it doesn't need a tree.
+ */
+UCLASS()
+class CREATIVEGAME_API UECSNearestNeighborSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Convenience accessor for the subsystem of a world context object's world
+	static UECSNearestNeighborSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+
+	// K nearest registered actors of ClassFilter for each query point, OutNeighbors[Query * K + N] is the N-th closest.
+	// Slots without a neighbour are null. IgnoreActors is empty or holds one actor per query, typically the querying agent.
+	void FindKNearest(const UClass* ClassFilter, TConstArrayView<FVector> QueryPoints, int32 K, TArray<AActor*>& OutNeighbors,
+		TArray<float>* OutDistancesSquared = nullptr, TConstArrayView<const AActor*> IgnoreActors = TConstArrayView<const AActor*>());
+
+	// Blueprint version of FindKNearest
+	UFUNCTION(BlueprintCallable, Category = "ECS")
+	void FindKNearestECSActors(TSubclassOf<AActor> ActorClass, const TArray<FVector>& QueryPoints, int32 K, TArray<AActor*>& OutNeighbors);
+
+private:
+	const FECSKdTree& GetTree(const UClass* ClassFilter);
+
+	TMap<const UClass*, TUniquePtr<FECSKdTree>> Trees;
+};
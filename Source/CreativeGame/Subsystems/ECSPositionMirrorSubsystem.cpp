@@ -0,0 +1,195 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ECSPositionMirrorSubsystem.h"
+#include "ECSActorRegistrySubsystem.h"
+#include "ECSSpatialStats.h"
+#include "CoreGlobals.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Math/VectorRegister.h"
+#include <limits>
+
+DECLARE_CYCLE_STAT(TEXT("Position Mirror Refresh"), STAT_ECSSpatial_MirrorRefresh, STATGROUP_ECSSpatial);
+DECLARE_CYCLE_STAT(TEXT("SIMD Filter"), STAT_ECSSpatial_SimdFilter, STATGROUP_ECSSpatial);
+DECLARE_DWORD_COUNTER_STAT(TEXT("SIMD Filtered Candidates"), STAT_ECSSpatial_NumSimdCandidates, STATGROUP_ECSSpatial);
+
+// Append the lanes set in Mask, lanes of the NaN padding never match so no bounds check is needed
+static FORCEINLINE void AppendMatches(int32 Mask, int32 Base, TArray<int32>& OutIndices)
+{
+	while (Mask)
+	{
+		OutIndices.Add(Base + FMath::CountTrailingZeros(static_cast<uint32>(Mask)));
+		Mask &= Mask - 1;
+	}
+}
+
+UECSPositionMirrorSubsystem* UECSPositionMirrorSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UECSPositionMirrorSubsystem>() : nullptr;
+}
+
+bool UECSPositionMirrorSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// ECS actors only register once they begin play
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UECSPositionMirrorSubsystem::Deinitialize()
+{
+	Mirrors.Reset();
+
+	Super::Deinitialize();
+}
+
+const FECSPositionMirror& UECSPositionMirrorSubsystem::GetMirror(const UClass* ClassFilter)
+{
+	TUniquePtr<FECSPositionMirror>& Mirror = Mirrors.FindOrAdd(ClassFilter);
+	if (!Mirror)
+	{
+		Mirror = MakeUnique<FECSPositionMirror>();
+	}
+
+	const UECSActorRegistrySubsystem* Registry = UECSActorRegistrySubsystem::Get(this);
+	const uint32 Serial = Registry ? Registry->GetChangeSerial() : 0;
+	if (Mirror->RefreshedFrame == GFrameCounter && Mirror->RefreshedSerial == Serial && Mirror->RefreshedFrame != 0)
+	{
+		return *Mirror;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ECSSpatial_MirrorRefresh);
+
+	Mirror->RefreshedFrame = GFrameCounter;
+	Mirror->RefreshedSerial = Serial;
+	Mirror->Actors.Reset();
+	Mirror->X.Reset();
+	Mirror->Y.Reset();
+	Mirror->Z.Reset();
+
+	if (Registry)
+	{
+		Registry->ForEachActorOfClass(ClassFilter, [&Mirror](AActor* Actor)
+		{
+			const FVector Location = Actor->GetActorLocation();
+			Mirror->Actors.Add(Actor);
+			Mirror->X.Add(static_cast<float>(Location.X));
+			Mirror->Y.Add(static_cast<float>(Location.Y));
+			Mirror->Z.Add(static_cast<float>(Location.Z));
+		});
+	}
+
+	const int32 PaddedNum = Align(Mirror->Actors.Num(), 4);
+	const float Padding = std::numeric_limits<float>::quiet_NaN();
+	while (Mirror->X.Num() < PaddedNum)
+	{
+		Mirror->X.Add(Padding);
+		Mirror->Y.Add(Padding);
+		Mirror->Z.Add(Padding);
+	}
+
+	return *Mirror;
+}
+
+const FECSPositionMirror& UECSPositionMirrorSubsystem::FilterRadius(const UClass* ClassFilter, const FVector& Origin, float Radius, TArray<int32>& OutIndices)
+{
+	const FECSPositionMirror& Mirror = GetMirror(ClassFilter);
+	OutIndices.Reset();
+
+	SCOPE_CYCLE_COUNTER(STAT_ECSSpatial_SimdFilter);
+	INC_DWORD_STAT_BY(STAT_ECSSpatial_NumSimdCandidates, Mirror.Num());
+
+	const VectorRegister4Float OriginX = VectorSetFloat1(static_cast<float>(Origin.X));
+	const VectorRegister4Float OriginY = VectorSetFloat1(static_cast<float>(Origin.Y));
+	const VectorRegister4Float OriginZ = VectorSetFloat1(static_cast<float>(Origin.Z));
+	const VectorRegister4Float RadiusSquared = VectorSetFloat1(FMath::Square(Radius));
+
+	for (int32 Base = 0; Base < Mirror.X.Num(); Base += 4)
+	{
+		const VectorRegister4Float DeltaX = VectorSubtract(VectorLoadAligned(&Mirror.X[Base]), OriginX);
+		const VectorRegister4Float DeltaY = VectorSubtract(VectorLoadAligned(&Mirror.Y[Base]), OriginY);
+		const VectorRegister4Float DeltaZ = VectorSubtract(VectorLoadAligned(&Mirror.Z[Base]), OriginZ);
+		const VectorRegister4Float DistanceSquared = VectorMultiplyAdd(DeltaZ, DeltaZ, VectorMultiplyAdd(DeltaY, DeltaY, VectorMultiply(DeltaX, DeltaX)));
+
+		AppendMatches(VectorMaskBits(VectorCompareLE(DistanceSquared, RadiusSquared)), Base, OutIndices);
+	}
+
+	return Mirror;
+}
+
+const FECSPositionMirror& UECSPositionMirrorSubsystem::FilterBox(const UClass* ClassFilter, const FBox& Box, TArray<int32>& OutIndices)
+{
+	const FECSPositionMirror& Mirror = GetMirror(ClassFilter);
+	OutIndices.Reset();
+
+	SCOPE_CYCLE_COUNTER(STAT_ECSSpatial_SimdFilter);
+	INC_DWORD_STAT_BY(STAT_ECSSpatial_NumSimdCandidates, Mirror.Num());
+
+	const VectorRegister4Float MinX = VectorSetFloat1(static_cast<float>(Box.Min.X));
+	const VectorRegister4Float MinY = VectorSetFloat1(static_cast<float>(Box.Min.Y));
+	const VectorRegister4Float MinZ = VectorSetFloat1(static_cast<float>(Box.Min.Z));
+	const VectorRegister4Float MaxX = VectorSetFloat1(static_cast<float>(Box.Max.X));
+	const VectorRegister4Float MaxY = VectorSetFloat1(static_cast<float>(Box.Max.Y));
+	const VectorRegister4Float MaxZ = VectorSetFloat1(static_cast<float>(Box.Max.Z));
+
+	for (int32 Base = 0; Base < Mirror.X.Num(); Base += 4)
+	{
+		const VectorRegister4Float X = VectorLoadAligned(&Mirror.X[Base]);
+		const VectorRegister4Float Y = VectorLoadAligned(&Mirror.Y[Base]);
+		const VectorRegister4Float Z = VectorLoadAligned(&Mirror.Z[Base]);
+
+		VectorRegister4Float Inside = VectorBitwiseAnd(VectorCompareGE(X, MinX), VectorCompareLE(X, MaxX));
+		Inside = VectorBitwiseAnd(Inside, VectorBitwiseAnd(VectorCompareGE(Y, MinY), VectorCompareLE(Y, MaxY)));
+		Inside = VectorBitwiseAnd(Inside, VectorBitwiseAnd(VectorCompareGE(Z, MinZ), VectorCompareLE(Z, MaxZ)));
+
+		AppendMatches(VectorMaskBits(Inside), Base, OutIndices);
+	}
+
+	return Mirror;
+}
+
+const FECSPositionMirror& UECSPositionMirrorSubsystem::FilterCone(const UClass* ClassFilter, const FVector& Origin, const FVector& Direction, float HalfAngleDegrees, float Range, TArray<int32>& OutIndices)
+{
+	const FECSPositionMirror& Mirror = GetMirror(ClassFilter);
+	OutIndices.Reset();
+
+	SCOPE_CYCLE_COUNTER(STAT_ECSSpatial_SimdFilter);
+	INC_DWORD_STAT_BY(STAT_ECSSpatial_NumSimdCandidates, Mirror.Num());
+
+	const FVector3f Axis = FVector3f(Direction.GetSafeNormal());
+	const float CosHalfAngle = FMath::Cos(FMath::DegreesToRadians(FMath::Clamp(HalfAngleDegrees, 0.0f, 180.0f)));
+
+	const VectorRegister4Float OriginX = VectorSetFloat1(static_cast<float>(Origin.X));
+	const VectorRegister4Float OriginY = VectorSetFloat1(static_cast<float>(Origin.Y));
+	const VectorRegister4Float OriginZ = VectorSetFloat1(static_cast<float>(Origin.Z));
+	const VectorRegister4Float AxisX = VectorSetFloat1(Axis.X);
+	const VectorRegister4Float AxisY = VectorSetFloat1(Axis.Y);
+	const VectorRegister4Float AxisZ = VectorSetFloat1(Axis.Z);
+	const VectorRegister4Float RangeSquared = VectorSetFloat1(FMath::Square(Range));
+	const VectorRegister4Float CosSquared = VectorSetFloat1(FMath::Square(CosHalfAngle));
+	const VectorRegister4Float Zero = VectorZeroFloat();
+
+	// Compare squares to avoid a sqrt per candidate: Dot >= Cos * Distance, with the sign of Dot handled separately
+	const bool bNarrowCone = CosHalfAngle >= 0.0f;
+
+	for (int32 Base = 0; Base < Mirror.X.Num(); Base += 4)
+	{
+		const VectorRegister4Float DeltaX = VectorSubtract(VectorLoadAligned(&Mirror.X[Base]), OriginX);
+		const VectorRegister4Float DeltaY = VectorSubtract(VectorLoadAligned(&Mirror.Y[Base]), OriginY);
+		const VectorRegister4Float DeltaZ = VectorSubtract(VectorLoadAligned(&Mirror.Z[Base]), OriginZ);
+		const VectorRegister4Float DistanceSquared = VectorMultiplyAdd(DeltaZ, DeltaZ, VectorMultiplyAdd(DeltaY, DeltaY, VectorMultiply(DeltaX, DeltaX)));
+		const VectorRegister4Float Dot = VectorMultiplyAdd(DeltaZ, AxisZ, VectorMultiplyAdd(DeltaY, AxisY, VectorMultiply(DeltaX, AxisX)));
+
+		const VectorRegister4Float InFront = VectorCompareGE(Dot, Zero);
+		const VectorRegister4Float DotSquared = VectorMultiply(Dot, Dot);
+		const VectorRegister4Float ConeBoundSquared = VectorMultiply(CosSquared, DistanceSquared);
+
+		// Narrower than a hemisphere: in front and inside the cone. Wider: in front, or behind but outside the excluded cone.
+		const VectorRegister4Float InCone = bNarrowCone
+			? VectorBitwiseAnd(InFront, VectorCompareGE(DotSquared, ConeBoundSquared))
+			: VectorBitwiseOr(InFront, VectorCompareLE(DotSquared, ConeBoundSquared));
+
+		AppendMatches(VectorMaskBits(VectorBitwiseAnd(InCone, VectorCompareLE(DistanceSquared, RangeSquared))), Base, OutIndices);
+	}
+
+	return Mirror;
+}
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "ECSPositionMirrorSubsystem.generated.h"
+
+/**
+ * Positions of the registered ECS actors of a class as packed X, Y and Z float arrays.
+ * The arrays are 16-byte aligned and padded with NaN to a multiple of 4, so filters always load whole
+ * vector registers and padding never passes a comparison.
+ */
+struct FECSPositionMirror
+{
+	TArray<float, TAlignedHeapAllocator<16>> X;
+	TArray<float, TAlignedHeapAllocator<16>> Y;
+	TArray<float, TAlignedHeapAllocator<16>> Z;
+
+	// Actors[Index] is at (X[Index], Y[Index], Z[Index])
+	TArray<AActor*> Actors;
+
+	// Frame and registry serial the mirror was refreshed for
+	uint64 RefreshedFrame = 0;
+	uint32 RefreshedSerial = 0;
+
+	int32 Num() const { return Actors.Num(); }
+};
+
+/**
+ * Packed per-frame copies of ECS actor positions with SIMD batch filters.
+ * The first filter for a class in a frame copies the positions of its registered actors out of UECSActorRegistrySubsystem,
+ * later filters that frame only touch the packed arrays. Each filter tests 4 candidates per instruction with
+ * VectorRegister4Float and returns the indices of the matches into FECSPositionMirror::Actors.
+ *
+ * Positions are those at the first filter of the frame, actors moved later in the frame are seen at their old location.
+ */
+UCLASS()
+class CREATIVEGAME_API UECSPositionMirrorSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Convenience accessor for the subsystem of a world context object's world
+	static UECSPositionMirrorSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+
+	// Mirror of ClassFilter (or every ECS actor when null), refreshed if this is the first use this frame
+	const FECSPositionMirror& GetMirror(const UClass* ClassFilter);
+
+	// Indices of the mirrored actors within Radius of Origin
+	const FECSPositionMirror& FilterRadius(const UClass* ClassFilter, const FVector& Origin, float Radius, TArray<int32>& OutIndices);
+
+	// Indices of the mirrored actors inside Box
+	const FECSPositionMirror& FilterBox(const UClass* ClassFilter, const FBox& Box, TArray<int32>& OutIndices);
+
+	// Indices of the mirrored actors within Range of Origin and HalfAngleDegrees of Direction
+	const FECSPositionMirror& FilterCone(const UClass* ClassFilter, const FVector& Origin, const FVector& Direction, float HalfAngleDegrees, float Range, TArray<int32>& OutIndices);
+
+private:
+	TMap<const UClass*, TUniquePtr<FECSPositionMirror>> Mirrors;
+};
@@ -0,0 +1,280 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ECSSpatialHashSubsystem.h"
+#include "ECSSpatialStats.h"
+#include "Components/SceneComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Radius Query"), STAT_ECSSpatial_RadiusQuery, STATGROUP_ECSSpatial);
+DECLARE_CYCLE_STAT(TEXT("Closest Query"), STAT_ECSSpatial_ClosestQuery, STATGROUP_ECSSpatial);
+DECLARE_CYCLE_STAT(TEXT("Move Actor"), STAT_ECSSpatial_MoveActor, STATGROUP_ECSSpatial);
+
+static TAutoConsoleVariable<float> CVarECSSpatialCellSize(
+	TEXT("ECS.Spatial.CellSize"),
+	1000.0f,
+	TEXT("Edge length in cm of the cells in the ECS spatial hash. Applied when a world is created.\n")
+	TEXT("Pick something close to the radius used by the common GetNearbyECS* queries."),
+	ECVF_Default);
+
+UECSSpatialHashSubsystem* UECSSpatialHashSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UECSSpatialHashSubsystem>() : nullptr;
+}
+
+bool UECSSpatialHashSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// ECS actors only register once they begin play
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UECSSpatialHashSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	CellSize = FMath::Max(CVarECSSpatialCellSize.GetValueOnGameThread(), 1.0f);
+	InvCellSize = 1.0f / CellSize;
+}
+
+void UECSSpatialHashSubsystem::Deinitialize()
+{
+	for (TPair<const AActor*, FECSSpatialHashEntry>& Pair : Entries)
+	{
+		if (USceneComponent* Root = Pair.Value.RootComponent.Get())
+		{
+			Root->TransformUpdated.Remove(Pair.Value.TransformUpdatedHandle);
+		}
+	}
+
+	Entries.Reset();
+	Cells.Reset();
+
+	Super::Deinitialize();
+}
+
+void UECSSpatialHashSubsystem::RegisterActor(AActor* Actor)
+{
+	if (!IsValid(Actor) || Entries.Contains(Actor))
+	{
+		return;
+	}
+
+	++ChangeSerial;
+	FECSSpatialHashEntry& Entry = Entries.Add(Actor);
+	const FVector Location = Actor->GetActorLocation();
+	AddToCell(Actor, Entry, ToCell(Location), Location);
+
+	// Follow the actor incrementally instead of rescanning every frame
+	if (USceneComponent* Root = Actor->GetRootComponent())
+	{
+		Entry.RootComponent = Root;
+		Entry.TransformUpdatedHandle = Root->TransformUpdated.AddUObject(this, &UECSSpatialHashSubsystem::OnRootTransformUpdated);
+	}
+}
+
+void UECSSpatialHashSubsystem::UnregisterActor(AActor* Actor)
+{
+	FECSSpatialHashEntry Entry;
+	if (!Entries.RemoveAndCopyValue(Actor, Entry))
+	{
+		return;
+	}
+
+	++ChangeSerial;
+	if (USceneComponent* Root = Entry.RootComponent.Get())
+	{
+		Root->TransformUpdated.Remove(Entry.TransformUpdatedHandle);
+	}
+
+	RemoveFromCell(Entry);
+}
+
+void UECSSpatialHashSubsystem::OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	if (UpdatedComponent)
+	{
+		MoveActor(UpdatedComponent->GetOwner(), UpdatedComponent->GetComponentLocation());
+	}
+}
+
+void UECSSpatialHashSubsystem::MoveActor(AActor* Actor, const FVector& NewLocation)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ECSSpatial_MoveActor);
+
+	FECSSpatialHashEntry* Entry = Entries.Find(Actor);
+	if (!Entry)
+	{
+		return;
+	}
+
+	++ChangeSerial;
+	const FIntVector NewCell = ToCell(NewLocation);
+	if (NewCell == Entry->Cell)
+	{
+		// Still in the same cell, only refresh the cached location
+		Cells.FindChecked(Entry->Cell)[Entry->IndexInCell].Location = NewLocation;
+		return;
+	}
+
+	RemoveFromCell(*Entry);
+	AddToCell(Actor, *Entry, NewCell, NewLocation);
+}
+
+void UECSSpatialHashSubsystem::AddToCell(AActor* Actor, FECSSpatialHashEntry& Entry, const FIntVector& Cell, const FVector& Location)
+{
+	TArray<FECSSpatialHashCellEntry>& CellEntries = Cells.FindOrAdd(Cell);
+	Entry.Cell = Cell;
+	Entry.IndexInCell = CellEntries.Add({ Actor, Location });
+}
+
+void UECSSpatialHashSubsystem::RemoveFromCell(const FECSSpatialHashEntry& Entry)
+{
+	TArray<FECSSpatialHashCellEntry>* CellEntries = Cells.Find(Entry.Cell);
+	if (!CellEntries || !CellEntries->IsValidIndex(Entry.IndexInCell))
+	{
+		return;
+	}
+
+	CellEntries->RemoveAtSwap(Entry.IndexInCell, 1, EAllowShrinking::No);
+	if (CellEntries->IsValidIndex(Entry.IndexInCell))
+	{
+		// Fix up the index of the actor that was swapped into the freed slot
+		if (FECSSpatialHashEntry* MovedEntry = Entries.Find((*CellEntries)[Entry.IndexInCell].Actor))
+		{
+			MovedEntry->IndexInCell = Entry.IndexInCell;
+		}
+	}
+	else if (CellEntries->IsEmpty())
+	{
+		Cells.Remove(Entry.Cell);
+	}
+}
+
+template<typename VisitorType>
+void UECSSpatialHashSubsystem::VisitActorsInRadius(const FVector& Origin, float Radius, const UClass* ClassFilter, const AActor* IgnoreActor, VisitorType&& Visitor) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ECSSpatial_RadiusQuery);
+
+	if (Radius < 0.0f || Cells.IsEmpty())
+	{
+		return;
+	}
+
+	const float RadiusSquared = FMath::Square(Radius);
+	auto VisitCell = [&](const TArray<FECSSpatialHashCellEntry>& CellEntries)
+	{
+		for (const FECSSpatialHashCellEntry& CellEntry : CellEntries)
+		{
+			const double DistanceSquared = FVector::DistSquared(CellEntry.Location, Origin);
+			if (CellEntry.Actor != IgnoreActor
+				&& DistanceSquared <= RadiusSquared
+				&& (!ClassFilter || CellEntry.Actor->IsA(ClassFilter)))
+			{
+				Visitor(CellEntry.Actor, static_cast<float>(DistanceSquared));
+			}
+		}
+	};
+
+	// Huge radii would visit more empty cells than there are occupied ones, so just walk the occupied cells
+	const double CellsPerAxis = 2.0 * Radius * InvCellSize + 2.0;
+	if (CellsPerAxis * CellsPerAxis * CellsPerAxis > Cells.Num())
+	{
+		for (const TPair<FIntVector, TArray<FECSSpatialHashCellEntry>>& Cell : Cells)
+		{
+			VisitCell(Cell.Value);
+		}
+		return;
+	}
+
+	const FIntVector MinCell = ToCell(Origin - FVector(Radius));
+	const FIntVector MaxCell = ToCell(Origin + FVector(Radius));
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+			{
+				if (const TArray<FECSSpatialHashCellEntry>* CellEntries = Cells.Find(FIntVector(X, Y, Z)))
+				{
+					VisitCell(*CellEntries);
+				}
+			}
+		}
+	}
+}
+
+void UECSSpatialHashSubsystem::ForEachActorInRadius(const FVector& Origin, float Radius, const UClass* ClassFilter, const AActor* IgnoreActor, TFunctionRef<void(AActor*)> Visitor) const
+{
+	VisitActorsInRadius(Origin, Radius, ClassFilter, IgnoreActor, [&Visitor](AActor* Actor, float DistanceSquared)
+	{
+		Visitor(Actor);
+	});
+}
+
+void UECSSpatialHashSubsystem::ForEachActorInRadiusWithDistance(const FVector& Origin, float Radius, const UClass* ClassFilter, const AActor* IgnoreActor, TFunctionRef<void(AActor*, float)> Visitor) const
+{
+	VisitActorsInRadius(Origin, Radius, ClassFilter, IgnoreActor, Visitor);
+}
+
+AActor* UECSSpatialHashSubsystem::FindClosestActor(const FVector& Origin, const UClass* ClassFilter, const AActor* IgnoreActor) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ECSSpatial_ClosestQuery);
+
+	AActor* ClosestActor = nullptr;
+	float ClosestDistanceSquared = TNumericLimits<float>::Max();
+
+	auto ConsiderCell = [&](const TArray<FECSSpatialHashCellEntry>& CellEntries)
+	{
+		for (const FECSSpatialHashCellEntry& CellEntry : CellEntries)
+		{
+			const float DistanceSquared = FVector::DistSquared(CellEntry.Location, Origin);
+			if (DistanceSquared < ClosestDistanceSquared && CellEntry.Actor != IgnoreActor && (!ClassFilter || CellEntry.Actor->IsA(ClassFilter)))
+			{
+				ClosestDistanceSquared = DistanceSquared;
+				ClosestActor = CellEntry.Actor;
+			}
+		}
+	};
+
+	const FIntVector OriginCell = ToCell(Origin);
+	for (int32 Ring = 0; ; ++Ring)
+	{
+		// Once a ring would cover more cells than are occupied, finish with a scan of the occupied cells
+		const int64 RingSpan = 2 * Ring + 1;
+		if (RingSpan * RingSpan * RingSpan > Cells.Num())
+		{
+			for (const TPair<FIntVector, TArray<FECSSpatialHashCellEntry>>& Cell : Cells)
+			{
+				ConsiderCell(Cell.Value);
+			}
+			break;
+		}
+
+		// Visit only the shell of cells at Chebyshev distance Ring from the origin cell
+		for (int32 X = -Ring; X <= Ring; ++X)
+		{
+			for (int32 Y = -Ring; Y <= Ring; ++Y)
+			{
+				const bool bOnShellXY = FMath::Abs(X) == Ring || FMath::Abs(Y) == Ring;
+				const int32 ZStep = bOnShellXY ? 1 : FMath::Max(2 * Ring, 1);
+				for (int32 Z = -Ring; Z <= Ring; Z += ZStep)
+				{
+					if (const TArray<FECSSpatialHashCellEntry>* CellEntries = Cells.Find(OriginCell + FIntVector(X, Y, Z)))
+					{
+						ConsiderCell(*CellEntries);
+					}
+				}
+			}
+		}
+
+		// Anything beyond this ring is at least Ring cells away from the origin
+		if (ClosestActor && ClosestDistanceSquared <= FMath::Square(Ring * CellSize))
+		{
+			break;
+		}
+	}
+
+	return ClosestActor;
+}
@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Templates/Function.h"
+
+class USceneComponent;
+
+#include "ECSSpatialHashSubsystem.generated.h"
+
+/**
+ * Actor stored in a spatial hash cell, with its location cached so queries never touch the actor itself.
+ */
+struct FECSSpatialHashCellEntry
+{
+	AActor* Actor = nullptr;
+	FVector Location = FVector::ZeroVector;
+};
+
+/**
+ * Bookkeeping for a registered actor, used to move it between cells in O(1).
+ */
+struct FECSSpatialHashEntry
+{
+	FIntVector Cell = FIntVector::ZeroValue;
+	int32 IndexInCell = INDEX_NONE;
+	TWeakObjectPtr<USceneComponent> RootComponent;
+	FDelegateHandle TransformUpdatedHandle;
+};
+
+/**
+ * Uniform spatial hash of every ECS actor, pawn and character in the world.
+ * Actors register at BeginPlay and unregister at EndPlay, and are moved between cells incrementally
+ * whenever their root component's transform changes, so stationary actors cost nothing to keep indexed.
+ * Radius queries only visit the cells overlapping the query sphere instead of scanning every actor.
+ *
+ * The cell size is read from ECS.Spatial.CellSize when the world is created.
+ */
+UCLASS()
+class CREATIVEGAME_API UECSSpatialHashSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Convenience accessor for the subsystem of a world context object's world
+	static UECSSpatialHashSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Registration - called by the ECS base classes at BeginPlay/EndPlay
+	void RegisterActor(AActor* Actor);
+	void UnregisterActor(AActor* Actor);
+
+	// Visit every registered actor of ClassFilter (or any class when null) within Radius of Origin
+	void ForEachActorInRadius(const FVector& Origin, float Radius, const UClass* ClassFilter, const AActor* IgnoreActor, TFunctionRef<void(AActor*)> Visitor) const;
+
+	// Same as ForEachActorInRadius, also passing the squared distance from Origin to the actor's indexed location
+	void ForEachActorInRadiusWithDistance(const FVector& Origin, float Radius, const UClass* ClassFilter, const AActor* IgnoreActor, TFunctionRef<void(AActor*, float)> Visitor) const;
+
+	// Closest registered actor of ClassFilter (or any class when null), searching outwards ring by ring
+	AActor* FindClosestActor(const FVector& Origin, const UClass* ClassFilter, const AActor* IgnoreActor) const;
+
+	// Typed radius query used by the GetNearbyECS* helpers
+	template<typename T>
+	void QueryRadius(const FVector& Origin, float Radius, const AActor* IgnoreActor, TArray<T*>& OutActors) const
+	{
+		ForEachActorInRadius(Origin, Radius, T::StaticClass(), IgnoreActor, [&OutActors](AActor* Actor)
+		{
+			OutActors.Add(static_cast<T*>(Actor));
+		});
+	}
+
+	UFUNCTION(BlueprintPure, Category = "ECS")
+	int32 GetNumRegisteredActors() const { return Entries.Num(); }
+
+	UFUNCTION(BlueprintPure, Category = "ECS")
+	float GetCellSize() const { return CellSize; }
+
+	// Incremented whenever an actor registers, unregisters or moves, so cached query results can tell they are stale
+	uint32 GetChangeSerial() const { return ChangeSerial; }
+
+private:
+	void OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+	void MoveActor(AActor* Actor, const FVector& NewLocation);
+	void AddToCell(AActor* Actor, FECSSpatialHashEntry& Entry, const FIntVector& Cell, const FVector& Location);
+	void RemoveFromCell(const FECSSpatialHashEntry& Entry);
+
+	// Radius query shared by the public variants, Visitor is called with each match and its squared distance
+	template<typename VisitorType>
+	void VisitActorsInRadius(const FVector& Origin, float Radius, const UClass* ClassFilter, const AActor* IgnoreActor, VisitorType&& Visitor) const;
+
+	FIntVector ToCell(const FVector& Location) const
+	{
+		return FIntVector(
+			FMath::FloorToInt32(Location.X * InvCellSize),
+			FMath::FloorToInt32(Location.Y * InvCellSize),
+			FMath::FloorToInt32(Location.Z * InvCellSize));
+	}
+
+	float CellSize = 1000.0f;
+	float InvCellSize = 1.0f / 1000.0f;
+	uint32 ChangeSerial = 0;
+
+	TMap<const AActor*, FECSSpatialHashEntry> Entries;
+	TMap<FIntVector, TArray<FECSSpatialHashCellEntry>> Cells;
+};
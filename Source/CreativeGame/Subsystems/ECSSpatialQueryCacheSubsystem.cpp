@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ECSSpatialQueryCacheSubsystem.h"
+#include "ECSSpatialStats.h"
+#include "Algo/BinarySearch.h"
+#include "CoreGlobals.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Query Cache Hits"), STAT_ECSSpatial_QueryCacheHits, STATGROUP_ECSSpatial);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Query Cache Misses"), STAT_ECSSpatial_QueryCacheMisses, STATGROUP_ECSSpatial);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Query Cache Invalidations"), STAT_ECSSpatial_QueryCacheInvalidations, STATGROUP_ECSSpatial);
+
+static TAutoConsoleVariable<bool> CVarECSSpatialQueryCacheEnabled(
+	TEXT("ECS.Spatial.QueryCache.Enabled"),
+	true,
+	TEXT("Memoise GetNearbyECS* radius queries per origin actor, class and radius bucket for the rest of the frame."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarECSSpatialQueryCacheBucketSize(
+	TEXT("ECS.Spatial.QueryCache.BucketSize"),
+	100.0f,
+	TEXT("Radii are rounded up to a multiple of this many cm to pick a cache entry.\n")
+	TEXT("Larger buckets share entries between more radii at the cost of gathering and sorting more actors on a miss."),
+	ECVF_Default);
+
+UECSSpatialQueryCacheSubsystem* UECSSpatialQueryCacheSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UECSSpatialQueryCacheSubsystem>() : nullptr;
+}
+
+bool UECSSpatialQueryCacheSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// ECS actors only register once they begin play
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UECSSpatialQueryCacheSubsystem::Deinitialize()
+{
+	Results.Reset();
+
+	Super::Deinitialize();
+}
+
+FECSSpatialQueryView UECSSpatialQueryCacheSubsystem::QueryRadius(const AActor* OriginActor, float Radius, const UClass* ClassFilter)
+{
+	check(IsInGameThread());
+
+	FECSSpatialQueryView View;
+	const UECSSpatialHashSubsystem* SpatialHash = UECSSpatialHashSubsystem::Get(this);
+	if (!SpatialHash || !OriginActor || Radius < 0.0f)
+	{
+		return View;
+	}
+
+	const FVector Origin = OriginActor->GetActorLocation();
+	if (!IsCacheEnabled())
+	{
+		// Nothing is shared, so skip the sort and hand out the hash's own order
+		TSharedRef<FECSSpatialQueryCacheResult> Result = MakeShared<FECSSpatialQueryCacheResult>();
+		Result->Origin = Origin;
+		SpatialHash->ForEachActorInRadiusWithDistance(Origin, Radius, ClassFilter, OriginActor, [&Result](AActor* Actor, float DistanceSquared)
+		{
+			Result->Actors.Add(Actor);
+			Result->DistancesSquared.Add(DistanceSquared);
+		});
+		View.NumActors = Result->Actors.Num();
+		View.Result = Result;
+		return View;
+	}
+
+	// Results only hold while nothing in the hash moved, and actors move every frame
+	const uint32 Serial = SpatialHash->GetChangeSerial();
+	if (CachedFrame != GFrameCounter || CachedSerial != Serial)
+	{
+		Invalidate();
+		CachedFrame = GFrameCounter;
+		CachedSerial = Serial;
+	}
+
+	const float BucketSize = FMath::Max(CVarECSSpatialQueryCacheBucketSize.GetValueOnGameThread(), 1.0f);
+	const int32 RadiusBucket = static_cast<int32>(FMath::Min(FMath::CeilToDouble(Radius / BucketSize), static_cast<double>(MAX_int32)));
+
+	TSharedPtr<FECSSpatialQueryCacheResult>& Result = Results.FindOrAdd({ OriginActor, ClassFilter, RadiusBucket });
+
+	// Origins outside the hash (controllers, non-ECS actors) can move without bumping its serial
+	if (Result && Result->Origin == Origin)
+	{
+		++NumHits;
+		INC_DWORD_STAT(STAT_ECSSpatial_QueryCacheHits);
+	}
+	else
+	{
+		++NumMisses;
+		INC_DWORD_STAT(STAT_ECSSpatial_QueryCacheMisses);
+		Result = GatherResult(OriginActor, Origin, RadiusBucket * BucketSize, ClassFilter);
+	}
+
+	View.Result = Result;
+	View.NumActors = CountWithin(*Result, Radius);
+	return View;
+}
+
+TSharedRef<FECSSpatialQueryCacheResult> UECSSpatialQueryCacheSubsystem::GatherResult(const AActor* OriginActor, const FVector& Origin, float Radius, const UClass* ClassFilter) const
+{
+	TArray<TPair<float, AActor*>> Found;
+	if (const UECSSpatialHashSubsystem* SpatialHash = UECSSpatialHashSubsystem::Get(this))
+	{
+		// Sort by the distance the hash already tested against its indexed locations instead of reading the actors again
+		SpatialHash->ForEachActorInRadiusWithDistance(Origin, Radius, ClassFilter, OriginActor, [&Found](AActor* Actor, float DistanceSquared)
+		{
+			Found.Add(TPair<float, AActor*>(DistanceSquared, Actor));
+		});
+	}
+
+	// Closest first, so every smaller radius in the bucket is a prefix
+	Found.Sort([](const TPair<float, AActor*>& A, const TPair<float, AActor*>& B) { return A.Key < B.Key; });
+
+	TSharedRef<FECSSpatialQueryCacheResult> Result = MakeShared<FECSSpatialQueryCacheResult>();
+	Result->Origin = Origin;
+	Result->Actors.Reserve(Found.Num());
+	Result->DistancesSquared.Reserve(Found.Num());
+	for (const TPair<float, AActor*>& Pair : Found)
+	{
+		Result->DistancesSquared.Add(Pair.Key);
+		Result->Actors.Add(Pair.Value);
+	}
+
+	return Result;
+}
+
+bool UECSSpatialQueryCacheSubsystem::IsCacheEnabled()
+{
+	return CVarECSSpatialQueryCacheEnabled.GetValueOnGameThread();
+}
+
+int32 UECSSpatialQueryCacheSubsystem::CountWithin(const FECSSpatialQueryCacheResult& Result, float Radius)
+{
+	return Algo::UpperBound(Result.DistancesSquared, FMath::Square(Radius));
+}
+
+void UECSSpatialQueryCacheSubsystem::Invalidate()
+{
+	// Views handed out keep their own reference, only the cache lets go of the results
+	if (!Results.IsEmpty())
+	{
+		INC_DWORD_STAT(STAT_ECSSpatial_QueryCacheInvalidations);
+		Results.Reset();
+	}
+}
+
+float UECSSpatialQueryCacheSubsystem::GetQueryCacheHitRate() const
+{
+	const uint64 NumQueries = NumHits + NumMisses;
+	return NumQueries > 0 ? static_cast<float>(static_cast<double>(NumHits) / static_cast<double>(NumQueries)) : 0.0f;
+}
+
+void UECSSpatialQueryCacheSubsystem::ResetQueryCacheCounters()
+{
+	NumHits = 0;
+	NumMisses = 0;
+}
@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ECSSpatialHashSubsystem.h"
+#include "GameFramework/Actor.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "ECSSpatialQueryCacheSubsystem.generated.h"
+
+/**
+ * Actors found around an origin actor out to the radius of a bucket, sorted closest first.
+ */
+struct FECSSpatialQueryCacheResult
+{
+	TArray<AActor*> Actors;
+	TArray<float> DistancesSquared;
+
+	// Where the origin actor was when the result was gathered
+	FVector Origin = FVector::ZeroVector;
+};
+
+/**
+ * Read-only view of the first Num actors of a shared cached result, the ones within the radius that was asked for.
+ * Holding a view keeps its result alive after the cache moved on, so it stays valid for as long as it is held.
+ */
+struct FECSSpatialQueryView
+{
+	TSharedPtr<const FECSSpatialQueryCacheResult> Result;
+	int32 NumActors = 0;
+
+	int32 Num() const { return NumActors; }
+	bool IsEmpty() const { return NumActors == 0; }
+
+	// Closest first while the cache is enabled
+	TConstArrayView<AActor*> GetActors() const { return Result ? TConstArrayView<AActor*>(Result->Actors.GetData(), NumActors) : TConstArrayView<AActor*>(); }
+	TConstArrayView<float> GetDistancesSquared() const { return Result ? TConstArrayView<float>(Result->DistancesSquared.GetData(), NumActors) : TConstArrayView<float>(); }
+
+	// Results are filtered by T when queried, so the cast is always valid
+	template<typename T>
+	void AppendTo(TArray<T*>& OutActors) const
+	{
+		OutActors.Reserve(OutActors.Num() + NumActors);
+		for (AActor* Actor : GetActors())
+		{
+			OutActors.Add(static_cast<T*>(Actor));
+		}
+	}
+};
+
+/**
+ * Key of a cached query: who asked, for which class, and the radius rounded up to a bucket.
+ */
+struct FECSSpatialQueryCacheKey
+{
+	const AActor* OriginActor = nullptr;
+	const UClass* ClassFilter = nullptr;
+	int32 RadiusBucket = 0;
+
+	bool operator==(const FECSSpatialQueryCacheKey& Other) const
+	{
+		return OriginActor == Other.OriginActor && ClassFilter == Other.ClassFilter && RadiusBucket == Other.RadiusBucket;
+	}
+
+	friend uint32 GetTypeHash(const FECSSpatialQueryCacheKey& Key)
+	{
+		return HashCombineFast(HashCombineFast(GetTypeHash(Key.OriginActor), GetTypeHash(Key.ClassFilter)), GetTypeHash(Key.RadiusBucket));
+	}
+};
+
+/**
+ * Frame-scoped memoisation of radius queries around an actor, in front of UECSSpatialHashSubsystem.
+ *
+ * Capabilities on the same actor tend to ask for the same neighbours several times a frame (targeting, avoidance, HUD).
+ * The first query for an (origin actor, class, radius bucket) gathers everything out to the bucket's radius from the
+ * spatial hash and sorts it by distance; later queries in the same bucket return a view of the prefix within their exact
+ * radius, so results are identical to an uncached query apart from being ordered closest first.
+ *
+ * Everything cached is dropped when the frame advances or the spatial hash changes (an actor registering, unregistering
+ * or moving). The bucket size is ECS.Spatial.QueryCache.BucketSize. With ECS.Spatial.QueryCache.Enabled 0 the typed
+ * QueryRadius is the plain spatial hash query again, and views hold an unsorted result gathered for that one call.
+ */
+UCLASS()
+class CREATIVEGAME_API UECSSpatialQueryCacheSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Convenience accessor for the subsystem of a world context object's world
+	static UECSSpatialQueryCacheSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+
+	// Registered actors of ClassFilter (or any class when null) within Radius of OriginActor, excluding OriginActor itself
+	FECSSpatialQueryView QueryRadius(const AActor* OriginActor, float Radius, const UClass* ClassFilter);
+
+	// Typed radius query used by the GetNearbyECS* helpers
+	template<typename T>
+	void QueryRadius(const AActor* OriginActor, float Radius, TArray<T*>& OutActors)
+	{
+		if (IsCacheEnabled())
+		{
+			QueryRadius(OriginActor, Radius, T::StaticClass()).AppendTo(OutActors);
+			return;
+		}
+
+		// Cache off - exactly the uncached query, for A/B comparisons
+		const UECSSpatialHashSubsystem* SpatialHash = UECSSpatialHashSubsystem::Get(this);
+		if (SpatialHash && OriginActor)
+		{
+			SpatialHash->QueryRadius(OriginActor->GetActorLocation(), Radius, OriginActor, OutActors);
+		}
+	}
+
+	// ECS.Spatial.QueryCache.Enabled
+	static bool IsCacheEnabled();
+
+	// Drop every cached result now, for code that moved actors without going through their root component
+	void Invalidate();
+
+	// Fraction of cached queries answered without touching the spatial hash since the counters were last reset
+	UFUNCTION(BlueprintPure, Category = "ECS")
+	float GetQueryCacheHitRate() const;
+
+	UFUNCTION(BlueprintCallable, Category = "ECS")
+	void ResetQueryCacheCounters();
+
+	uint64 GetNumHits() const { return NumHits; }
+	uint64 GetNumMisses() const { return NumMisses; }
+
+private:
+	TSharedRef<FECSSpatialQueryCacheResult> GatherResult(const AActor* OriginActor, const FVector& Origin, float Radius, const UClass* ClassFilter) const;
+	static int32 CountWithin(const FECSSpatialQueryCacheResult& Result, float Radius);
+
+	TMap<FECSSpatialQueryCacheKey, TSharedPtr<FECSSpatialQueryCacheResult>> Results;
+
+	// Frame and spatial hash serial the cached results are valid for
+	uint64 CachedFrame = 0;
+	uint32 CachedSerial = 0;
+
+	uint64 NumHits = 0;
+	uint64 NumMisses = 0;
+};
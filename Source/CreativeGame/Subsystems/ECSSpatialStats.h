@@ -0,0 +1,9 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+// Shared stat group for the ECS spatial queries - view in game with "stat ECSSpatial"
+DECLARE_STATS_GROUP(TEXT("ECS Spatial"), STATGROUP_ECSSpatial, STATCAT_Advanced);
@@ -0,0 +1,16 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class CreativeGameTests : ModuleRules
+{
+	public CreativeGameTests(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		// Same standard as the CreativeGame headers included here
+		CppStandard = CppStandardVersion.Cpp20;
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "CreativeGame" });
+	}
+}
@@ -0,0 +1,6 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Modules/ModuleManager.h"
+
+// Benchmarks and automation tests of the ECS framework, never part of a shipping game
+IMPLEMENT_MODULE(FDefaultModuleImpl, CreativeGameTests);
@@ -0,0 +1,334 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ECSBenchmark.h"
+#include "BaseECSActor.h"
+#include "BaseECSPawn.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/DateTime.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+// Synthetic capabilities added to every benchmark entity
+static constexpr int32 CapabilitiesPerEntity = 4;
+
+// Every entity runs a radius query this wide, with neighbours spaced so it finds a handful of them
+static constexpr float QueryRadius = 1000.0f;
+static constexpr float EntitySpacing = 400.0f;
+
+// Upper bound on the queries per test, the per-call cost is what we compare
+static constexpr int32 MaxQueries = 10000;
+
+// Capabilities per actor and actor count cap of the component vs lightweight spawn comparison
+static constexpr int32 ManyCapabilitiesPerEntity = 12;
+static constexpr int32 MaxManyCapabilityEntities = 10000;
+
+void UECSBenchmarkCapability::TickCapability_Implementation(float DeltaTime)
+{
+	// Small fixed workload, kept observable so the compiler can't drop it
+	Accumulator = Accumulator * 0.99f + FVector(DeltaTime, Accumulator.X, Accumulator.Y);
+}
+
+bool UECSBenchmarkCapability::ShouldBeActive_Implementation()
+{
+	++NumActivationChecks;
+	return ActivationFlipInterval <= 0 || (NumActivationChecks / ActivationFlipInterval) % 2 == 0;
+}
+
+void UECSBenchmarkLightweightCapability::TickCapability_Implementation(float DeltaTime)
+{
+	Accumulator = Accumulator * 0.99f + FVector(DeltaTime, Accumulator.X, Accumulator.Y);
+}
+
+namespace ECSBenchmark
+{
+	static UCapabilityManagerComponent* GetManager(AActor* Entity)
+	{
+		if (ABaseECSActor* ECSActor = Cast<ABaseECSActor>(Entity))
+		{
+			return ECSActor->GetCapabilityManager();
+		}
+		if (ABaseECSPawn* ECSPawn = Cast<ABaseECSPawn>(Entity))
+		{
+			return ECSPawn->GetCapabilityManager();
+		}
+		return nullptr;
+	}
+
+	template<typename FunctorType>
+	static FResult Measure(int32 NumEntities, const TCHAR* Test, int32 NumCalls, FunctorType&& Functor)
+	{
+		const double StartSeconds = FPlatformTime::Seconds();
+		Functor();
+
+		FResult Result;
+		Result.NumEntities = NumEntities;
+		Result.Test = Test;
+		Result.NumCalls = NumCalls;
+		Result.TotalMs = (FPlatformTime::Seconds() - StartSeconds) * 1000.0;
+
+		UE_LOG(LogTemp, Log, TEXT("ECS.Benchmark %6d %-28s %10.3f ms total %10.3f us/call"),
+			NumEntities, Test, Result.TotalMs, Result.GetMicrosecondsPerCall());
+		return Result;
+	}
+
+	static void SpawnEntities(UWorld* World, UClass* EntityClass, int32 NumEntities, float ZOffset, TArray<AActor*>& OutEntities)
+	{
+		// Square grid, dense enough for every radius query to find neighbours
+		const int32 GridSize = FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(NumEntities)));
+
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+		SpawnParameters.bDeferConstruction = true;
+
+		for (int32 Index = 0; Index < NumEntities; ++Index)
+		{
+			const FVector Location((Index % GridSize) * EntitySpacing, (Index / GridSize) * EntitySpacing, ZOffset);
+			AActor* Entity = World->SpawnActor<AActor>(EntityClass, Location, FRotator::ZeroRotator, SpawnParameters);
+			UCapabilityManagerComponent* Manager = GetManager(Entity);
+			if (!Manager)
+			{
+				continue;
+			}
+
+			// ManualTick is measured directly, the scheduler must not tick the same managers too
+			Manager->SetUseCapabilityScheduler(false);
+			Entity->FinishSpawning(FTransform(Location));
+
+			for (int32 CapabilityIndex = 0; CapabilityIndex < CapabilitiesPerEntity; ++CapabilityIndex)
+			{
+				UECSBenchmarkCapability* Capability = Cast<UECSBenchmarkCapability>(Manager->AddCapability(UECSBenchmarkCapability::StaticClass()));
+				if (Capability)
+				{
+					// One capability per entity flips, the rest stay active
+					Capability->ActivationFlipInterval = CapabilityIndex == 0 ? 3 : 0;
+				}
+			}
+			OutEntities.Add(Entity);
+		}
+	}
+
+	// Time spawning actors that each get ManyCapabilitiesPerEntity capabilities from AddCapability, then destroy them
+	template<typename AddFunctorType>
+	static void MeasureManyCapabilitySpawn(UWorld* World, int32 NumEntities, const TCHAR* Test, AddFunctorType&& AddCapability, TArray<FResult>& OutResults)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+
+		TArray<AActor*> Entities;
+		Entities.Reserve(NumEntities);
+		OutResults.Add(Measure(NumEntities, Test, NumEntities, [&]()
+		{
+			for (int32 Index = 0; Index < NumEntities; ++Index)
+			{
+				ABaseECSActor* Entity = World->SpawnActor<ABaseECSActor>(ABaseECSActor::StaticClass(), FVector(Index * EntitySpacing, 0.0f, -100.0f), FRotator::ZeroRotator, SpawnParameters);
+				if (UCapabilityManagerComponent* Manager = Entity ? Entity->GetCapabilityManager() : nullptr)
+				{
+					for (int32 CapabilityIndex = 0; CapabilityIndex < ManyCapabilitiesPerEntity; ++CapabilityIndex)
+					{
+						AddCapability(Manager);
+					}
+					Entities.Add(Entity);
+				}
+			}
+		}));
+
+		for (AActor* Entity : Entities)
+		{
+			Entity->Destroy();
+		}
+	}
+
+	static void RunForCount(UWorld* World, int32 NumEntities, int32 NumFrames, TArray<FResult>& OutResults)
+	{
+		TArray<AActor*> Entities;
+		Entities.Reserve(NumEntities * 2);
+
+		OutResults.Add(Measure(NumEntities, TEXT("Spawn"), NumEntities * 2, [&]()
+		{
+			SpawnEntities(World, ABaseECSActor::StaticClass(), NumEntities, 0.0f, Entities);
+			SpawnEntities(World, ABaseECSPawn::StaticClass(), NumEntities, 100.0f, Entities);
+		}));
+
+		// Managers can still end up scheduled (e.g. a fixed timestep subclass), those are left to the scheduler
+		TArray<UCapabilityManagerComponent*> Managers;
+		Managers.Reserve(Entities.Num());
+		for (AActor* Entity : Entities)
+		{
+			UCapabilityManagerComponent* Manager = GetManager(Entity);
+			if (!Manager->IsTickedByScheduler())
+			{
+				Managers.Add(Manager);
+			}
+		}
+
+		const float DeltaTime = 1.0f / 60.0f;
+		OutResults.Add(Measure(NumEntities, TEXT("ManualTick"), Managers.Num() * NumFrames, [&]()
+		{
+			for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+			{
+				for (UCapabilityManagerComponent* Manager : Managers)
+				{
+					Manager->ManualTick(DeltaTime);
+				}
+			}
+		}));
+
+		OutResults.Add(Measure(NumEntities, TEXT("UpdateCapabilityStates"), Managers.Num() * NumFrames, [&]()
+		{
+			for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+			{
+				for (UCapabilityManagerComponent* Manager : Managers)
+				{
+					Manager->UpdateCapabilityStates();
+				}
+			}
+		}));
+
+		OutResults.Add(Measure(NumEntities, TEXT("AddRemoveCapability"), Managers.Num(), [&]()
+		{
+			for (UCapabilityManagerComponent* Manager : Managers)
+			{
+				Manager->RemoveCapability(Manager->AddCapability(UECSBenchmarkCapability::StaticClass()));
+			}
+		}));
+
+		OutResults.Add(Measure(NumEntities, TEXT("GetCapability"), Managers.Num() * NumFrames, [&]()
+		{
+			int32 NumFound = 0;
+			for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+			{
+				for (UCapabilityManagerComponent* Manager : Managers)
+				{
+					NumFound += Manager->GetCapability(UECSBenchmarkCapability::StaticClass()) ? 1 : 0;
+				}
+			}
+			check(NumFound >= 0);
+		}));
+
+		// Queries from the ECS actors only, the pawns sit in the same cells one layer up
+		const int32 NumQueries = FMath::Min(NumEntities, MaxQueries);
+		OutResults.Add(Measure(NumEntities, TEXT("GetNearbyECSActors"), NumQueries, [&]()
+		{
+			int32 NumFound = 0;
+			for (int32 Index = 0; Index < NumQueries; ++Index)
+			{
+				if (const ABaseECSActor* ECSActor = Cast<ABaseECSActor>(Entities[Index]))
+				{
+					NumFound += ECSActor->GetNearbyECSActors(QueryRadius).Num();
+				}
+			}
+			check(NumFound >= 0);
+		}));
+
+		OutResults.Add(Measure(NumEntities, TEXT("GetNearbyECSPawns"), NumQueries, [&]()
+		{
+			int32 NumFound = 0;
+			for (int32 Index = 0; Index < NumQueries; ++Index)
+			{
+				if (const ABaseECSActor* ECSActor = Cast<ABaseECSActor>(Entities[Index]))
+				{
+					NumFound += ECSActor->GetNearbyECSPawns(QueryRadius).Num();
+				}
+			}
+			check(NumFound >= 0);
+		}));
+
+		OutResults.Add(Measure(NumEntities, TEXT("Destroy"), Entities.Num(), [&]()
+		{
+			for (AActor* Entity : Entities)
+			{
+				Entity->Destroy();
+			}
+		}));
+
+		const int32 NumManyCapabilityEntities = FMath::Min(NumEntities, MaxManyCapabilityEntities);
+		MeasureManyCapabilitySpawn(World, NumManyCapabilityEntities, TEXT("SpawnManyCapabilities"), [](UCapabilityManagerComponent* Manager)
+		{
+			Manager->AddCapability(UECSBenchmarkCapability::StaticClass());
+		}, OutResults);
+		MeasureManyCapabilitySpawn(World, NumManyCapabilityEntities, TEXT("SpawnManyLightweightCapabilities"), [](UCapabilityManagerComponent* Manager)
+		{
+			Manager->AddLightweightCapability(UECSBenchmarkLightweightCapability::StaticClass());
+		}, OutResults);
+	}
+
+	TArray<FResult> Run(UWorld* World, const TArray<int32>& EntityCounts, int32 NumFrames)
+	{
+		TArray<FResult> Results;
+		if (!World || !World->HasBegunPlay())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ECS.Benchmark needs a world that has begun play"));
+			return Results;
+		}
+
+		for (const int32 NumEntities : EntityCounts)
+		{
+			if (NumEntities > 0)
+			{
+				RunForCount(World, NumEntities, FMath::Max(NumFrames, 1), Results);
+
+				// Don't let the previous count's garbage skew the next one
+				CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+			}
+		}
+
+		return Results;
+	}
+
+	FString WriteResults(const TArray<FResult>& Results, const FString& BaseName)
+	{
+		const FString BuildVersion = FApp::GetBuildVersion();
+		const FString Platform = FPlatformProperties::IniPlatformName();
+
+		FString Csv = TEXT("Build,Platform,Entities,Test,Calls,TotalMs,UsPerCall\n");
+		FString Json = FString::Printf(TEXT("{\n\t\"build\": \"%s\",\n\t\"platform\": \"%s\",\n\t\"engine\": \"%s\",\n\t\"results\": [\n"),
+			*BuildVersion, *Platform, *FEngineVersion::Current().ToString());
+
+		for (int32 Index = 0; Index < Results.Num(); ++Index)
+		{
+			const FResult& Result = Results[Index];
+			Csv += FString::Printf(TEXT("%s,%s,%d,%s,%d,%.4f,%.4f\n"),
+				*BuildVersion, *Platform, Result.NumEntities, *Result.Test, Result.NumCalls, Result.TotalMs, Result.GetMicrosecondsPerCall());
+			Json += FString::Printf(TEXT("\t\t{ \"entities\": %d, \"test\": \"%s\", \"calls\": %d, \"totalMs\": %.4f, \"usPerCall\": %.4f }%s\n"),
+				Result.NumEntities, *Result.Test, Result.NumCalls, Result.TotalMs, Result.GetMicrosecondsPerCall(), Index + 1 < Results.Num() ? TEXT(",") : TEXT(""));
+		}
+		Json += TEXT("\t]\n}\n");
+
+		const FString CsvPath = BaseName + TEXT(".csv");
+		FFileHelper::SaveStringToFile(Csv, *CsvPath);
+		FFileHelper::SaveStringToFile(Json, *(BaseName + TEXT(".json")));
+		return CsvPath;
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs ECSBenchmarkCommand(
+	TEXT("ECS.Benchmark"),
+	TEXT("Runs the ECS scale benchmark in the current world: ECS.Benchmark [EntityCounts=1000,10000,50000] [Frames=60].\n")
+	TEXT("Results are written to Saved/Profiling/ECSBenchmark as CSV and JSON."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		TArray<int32> EntityCounts = { 1000, 10000, 50000 };
+		if (Args.Num() > 0)
+		{
+			TArray<FString> CountStrings;
+			Args[0].ParseIntoArray(CountStrings, TEXT(","));
+			EntityCounts.Reset();
+			for (const FString& CountString : CountStrings)
+			{
+				EntityCounts.Add(FCString::Atoi(*CountString));
+			}
+		}
+		const int32 NumFrames = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 60;
+
+		const TArray<ECSBenchmark::FResult> Results = ECSBenchmark::Run(World, EntityCounts, NumFrames);
+		if (!Results.IsEmpty())
+		{
+			const FString BaseName = FPaths::ProfilingDir() / TEXT("ECSBenchmark") / FString::Printf(TEXT("ECSBenchmark-%s"), *FDateTime::Now().ToString());
+			UE_LOG(LogTemp, Log, TEXT("ECS.Benchmark results written to %s"), *ECSBenchmark::WriteResults(Results, BaseName));
+		}
+	}));
\ No newline at end of file
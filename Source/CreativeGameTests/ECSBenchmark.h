@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Capabilities/BaseCapability.h"
+#include "Capabilities/LightweightCapability.h"
+
+#include "ECSBenchmark.generated.h"
+
+/**
+ * Synthetic capability used by the ECS.Benchmark console command and automation tests.
+ * Does a small, fixed amount of work per tick and flips its activation every few checks so activation churn is measured too.
+ */
+UCLASS(Transient, NotBlueprintable, HideDropdown)
+class CREATIVEGAMETESTS_API UECSBenchmarkCapability : public UBaseCapability
+{
+	GENERATED_BODY()
+
+public:
+	virtual void TickCapability_Implementation(float DeltaTime) override;
+	virtual bool ShouldBeActive_Implementation() override;
+
+	// Checks between activation flips, 0 to stay active
+	int32 ActivationFlipInterval = 0;
+
+private:
+	FVector Accumulator = FVector::ZeroVector;
+	int32 NumActivationChecks = 0;
+};
+
+/**
+ * Lightweight counterpart of UECSBenchmarkCapability, used to compare spawn cost of actors carrying many capabilities.
+ */
+UCLASS(Transient, NotBlueprintable, HideDropdown)
+class CREATIVEGAMETESTS_API UECSBenchmarkLightweightCapability : public ULightweightCapability
+{
+	GENERATED_BODY()
+
+public:
+	virtual void TickCapability_Implementation(float DeltaTime) override;
+
+private:
+	FVector Accumulator = FVector::ZeroVector;
+};
+
+/**
+ * Headless scale benchmark of the ECS framework, run with the ECS.Benchmark console command, e.g.
+ *   UnrealEditor CreativeGame -game -nullrhi -unattended -ExecCmds="ECS.Benchmark 1000,10000,50000 60"
+ *
+ * For every count it spawns that many ABaseECSActor and ABaseECSPawn instances with synthetic capabilities and times
+ * ManualTick, UpdateCapabilityStates, AddCapability/RemoveCapability churn and GetNearbyECS* queries.
+ * It then compares spawning actors with many component capabilities against the same number of lightweight capabilities.
+ * Results are written as CSV and JSON to Saved/Profiling/ECSBenchmark so runs on the same machine can be compared.
+ * The same suite runs as the CreativeGame.ECS.Benchmark.* automation tests in the performance filter.
+ *
+ * Benchmark entities opt out of the capability scheduler, so ManualTick and UpdateCapabilityStates are measured on
+ * managers nothing else ticks.
+ */
+namespace ECSBenchmark
+{
+	struct FResult
+	{
+		int32 NumEntities = 0;
+		FString Test;
+		int32 NumCalls = 0;
+		double TotalMs = 0.0;
+
+		double GetMicrosecondsPerCall() const { return NumCalls > 0 ? TotalMs * 1000.0 / NumCalls : 0.0; }
+	};
+
+	// Run the whole suite in World, returns the results in the order they were measured
+	CREATIVEGAMETESTS_API TArray<FResult> Run(UWorld* World, const TArray<int32>& EntityCounts, int32 NumFrames);
+
+	// Write results next to each other as <BaseName>.csv and <BaseName>.json, returns the CSV path
+	CREATIVEGAMETESTS_API FString WriteResults(const TArray<FResult>& Results, const FString& BaseName);
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ECSBenchmark.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace ECSBenchmarkTests
+{
+	// Frames of ManualTick, UpdateCapabilityStates and GetCapability per count, same default as the console command
+	static constexpr int32 NumFrames = 60;
+
+	// Run the suite for one entity count in a fresh game world, so results don't depend on what the loaded map spawned
+	static bool RunInNewWorld(FAutomationTestBase& Test, int32 NumEntities)
+	{
+		UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("ECSBenchmarkWorld"));
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+
+		// BeginPlay only reaches AWorldSettings::NotifyBeginPlay through the game mode, which needs a game instance
+		UGameInstance* GameInstance = NewObject<UGameInstance>(GEngine);
+		GameInstance->AddToRoot();
+		WorldContext.OwningGameInstance = GameInstance;
+		World->SetGameInstance(GameInstance);
+
+		const FURL URL;
+		World->SetGameMode(URL);
+		World->InitializeActorsForPlay(URL);
+		World->BeginPlay();
+		Test.TestTrue(TEXT("Benchmark world has begun play"), World->HasBegunPlay());
+
+		const TArray<ECSBenchmark::FResult> Results = ECSBenchmark::Run(World, { NumEntities }, NumFrames);
+		for (const ECSBenchmark::FResult& Result : Results)
+		{
+			Test.AddInfo(FString::Printf(TEXT("%s: %.3f us/call (%d calls, %.3f ms total)"),
+				*Result.Test, Result.GetMicrosecondsPerCall(), Result.NumCalls, Result.TotalMs));
+		}
+
+		if (!Results.IsEmpty())
+		{
+			const FString BaseName = FPaths::ProfilingDir() / TEXT("ECSBenchmark") / FString::Printf(TEXT("ECSBenchmark-%d-%s"), NumEntities, *FDateTime::Now().ToString());
+			Test.AddInfo(FString::Printf(TEXT("Results written to %s"), *ECSBenchmark::WriteResults(Results, BaseName)));
+		}
+
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		World->RemoveFromRoot();
+		GameInstance->RemoveFromRoot();
+
+		return Test.TestFalse(TEXT("Benchmark produced results"), Results.IsEmpty());
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FECSBenchmark1000Test, "CreativeGame.ECS.Benchmark.1000", EAutomationTestFlags::PerfFilter | EAutomationTestFlags::ClientContext)
+bool FECSBenchmark1000Test::RunTest(const FString& Parameters)
+{
+	return ECSBenchmarkTests::RunInNewWorld(*this, 1000);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FECSBenchmark10000Test, "CreativeGame.ECS.Benchmark.10000", EAutomationTestFlags::PerfFilter | EAutomationTestFlags::ClientContext)
+bool FECSBenchmark10000Test::RunTest(const FString& Parameters)
+{
+	return ECSBenchmarkTests::RunInNewWorld(*this, 10000);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FECSBenchmark50000Test, "CreativeGame.ECS.Benchmark.50000", EAutomationTestFlags::PerfFilter | EAutomationTestFlags::ClientContext)
+bool FECSBenchmark50000Test::RunTest(const FString& Parameters)
+{
+	return ECSBenchmarkTests::RunInNewWorld(*this, 50000);
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS